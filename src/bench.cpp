@@ -0,0 +1,633 @@
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core/time.h"
+#include "net/scheduler.h"
+#include "net/discovery.h"
+#include "net/multicast.h"
+#include "net/message.h"
+#include "net/compress.h"
+#include "net/packet.h"
+
+// TYPES ////////////////////////////////////////////////////////////////////
+typedef void(*benchmark_cb)();
+
+struct Benchmark
+{
+   char const *name;
+   benchmark_cb run;
+};
+
+// SCHEDULER ////////////////////////////////////////////////////////////////
+#define SCHED_BENCH_QUEUED      (10000)
+#define SCHED_BENCH_TYPES       (16)
+#define SCHED_BENCH_BUDGET      (16 * 1024)
+#define SCHED_BENCH_TICKS       (1000)
+
+//-------------------------------------------------------------------------------------------------------
+static void CountPacket( void const*, size_t, void *user_arg )
+{
+   size_t *packets = (size_t*)user_arg;
+   ++(*packets);
+}
+
+//-------------------------------------------------------------------------------------------------------
+static void BenchScheduler()
+{
+   MessageScheduler *scheduler = new MessageScheduler();
+   for (uint32_t i = 0; i < SCHED_BENCH_TYPES; ++i) {
+      scheduler->set_priority( (uint8_t)i, (float)(i + 1) );
+   }
+
+   uint8_t payload[256];
+   memset( payload, 0xab, sizeof(payload) );
+   srand(0);
+
+   uint64_t enqueue_ops = 0;
+   uint64_t tick_ops = 0;
+   uint32_t enqueued = 0;
+   size_t packets = 0;
+   size_t bytes = 0;
+
+   for (uint32_t t = 0; t < SCHED_BENCH_TICKS; ++t) {
+      // keep the peer's queue topped up at the target depth
+      uint64_t start = TimeGetOpCount();
+      while (scheduler->get_queued_count() < SCHED_BENCH_QUEUED) {
+         uint8_t type = (uint8_t)(rand() % SCHED_BENCH_TYPES);
+         uint16_t size = (uint16_t)(8 + (rand() % 120));
+         scheduler->enqueue( type, payload, size );
+         ++enqueued;
+      }
+      enqueue_ops += TimeGetOpCount() - start;
+
+      start = TimeGetOpCount();
+      bytes += scheduler->tick( SCHED_BENCH_BUDGET, CountPacket, &packets );
+      tick_ops += TimeGetOpCount() - start;
+   }
+
+   double enqueue_secs = TimeOpCountToSeconds(enqueue_ops);
+   double tick_secs = TimeOpCountToSeconds(tick_ops);
+   printf( "scheduler: %u queued/peer, %u types, %uB budget, %u ticks\n",
+      SCHED_BENCH_QUEUED, SCHED_BENCH_TYPES, SCHED_BENCH_BUDGET, SCHED_BENCH_TICKS );
+   printf( "  enqueue: %.1f ns/msg (%u msgs)\n", 
+      (enqueued > 0) ? (enqueue_secs * 1e9 / enqueued) : 0.0, enqueued );
+   printf( "  tick:    %.2f us/tick, %zu packets, %.1f KB/tick\n",
+      tick_secs * 1e6 / SCHED_BENCH_TICKS, packets, (double)bytes / 1024.0 / SCHED_BENCH_TICKS );
+
+   delete scheduler;
+}
+
+// DISCOVERY ////////////////////////////////////////////////////////////////
+#define DISCOVERY_BENCH_HOSTS       (128)
+#define DISCOVERY_BENCH_TIMEOUT     (2.0)
+#define DISCOVERY_BENCH_LOOKUPS     (100000)
+
+//-------------------------------------------------------------------------------------------------------
+static void BenchDiscovery()
+{
+   // stand-in hosts all live on loopback, each on its own port
+   DiscoveryResponder *responders = new DiscoveryResponder[DISCOVERY_BENCH_HOSTS];
+   for (uint32_t i = 0; i < DISCOVERY_BENCH_HOSTS; ++i) {
+      char name[DISCOVERY_MAX_NAME];
+      sprintf_s( name, DISCOVERY_MAX_NAME, "host_%03u", i );
+      if (!responders[i].start( "127.0.0.1", 0, 5413, name )) {
+         printf( "discovery: failed to start responder %u.\n", i );
+         delete[] responders;
+         return;
+      }
+   }
+
+   DiscoveryClient client;
+   if (!client.start()) {
+      printf( "discovery: failed to start client.\n" );
+      delete[] responders;
+      return;
+   }
+
+   double start = TimeGetSeconds();
+   for (uint32_t i = 0; i < DISCOVERY_BENCH_HOSTS; ++i) {
+      sockaddr_in addr;
+      memset( &addr, 0, sizeof(addr) );
+      addr.sin_family = AF_INET;
+      addr.sin_port = htons( responders[i].get_port() );
+      inet_pton( AF_INET, "127.0.0.1", &addr.sin_addr );
+      client.send_query( (sockaddr*)&addr, sizeof(addr) );
+   }
+
+   uint32_t found = 0;
+   double elapsed = 0.0;
+   while ((found < DISCOVERY_BENCH_HOSTS) && (elapsed < DISCOVERY_BENCH_TIMEOUT)) {
+      for (uint32_t i = 0; i < DISCOVERY_BENCH_HOSTS; ++i) {
+         responders[i].update();
+      }
+      client.update();
+      client.get_hosts( &found );
+      elapsed = TimeGetSeconds() - start;
+   }
+
+   DiscoveredHost const *hosts = client.get_hosts( &found );
+   float total_ping = 0.0f;
+   for (uint32_t i = 0; i < found; ++i) {
+      total_ping += hosts[i].ping_ms;
+   }
+
+   printf( "discovery: %u/%u hosts in %.1f ms (%.0f ms max response delay), avg ping %.3f ms\n",
+      found, DISCOVERY_BENCH_HOSTS, elapsed * 1000.0, DISCOVERY_DEFAULT_MAX_DELAY * 1000.0,
+      (found > 0) ? (total_ping / found) : 0.0f );
+
+   // cache reads never touch the network
+   uint32_t hits = 0;
+   uint64_t lookup_start = TimeGetOpCount();
+   for (uint32_t i = 0; i < DISCOVERY_BENCH_LOOKUPS; ++i) {
+      uint32_t count;
+      client.get_hosts( &count );
+      hits += count;
+   }
+   double list_secs = TimeOpCountToSeconds( TimeGetOpCount() - lookup_start );
+
+   lookup_start = TimeGetOpCount();
+   for (uint32_t i = 0; i < DISCOVERY_BENCH_LOOKUPS; ++i) {
+      if (nullptr != client.find_host( "host_064" )) {
+         ++hits;
+      }
+   }
+   double find_secs = TimeOpCountToSeconds( TimeGetOpCount() - lookup_start );
+
+   printf( "  cache list: %.1f ns, cache find: %.1f ns (%u)\n",
+      list_secs * 1e9 / DISCOVERY_BENCH_LOOKUPS, find_secs * 1e9 / DISCOVERY_BENCH_LOOKUPS, hits );
+
+   client.stop();
+   delete[] responders;
+}
+
+// MULTICAST ////////////////////////////////////////////////////////////////
+#define MULTICAST_BENCH_GROUP       "239.255.54.13"
+#define MULTICAST_BENCH_PORT        (5416)
+#define MULTICAST_BENCH_MESSAGES    (200)
+#define MULTICAST_BENCH_BATCH       (10)      // drain receivers every this many messages
+#define MULTICAST_BENCH_SIZE        (256)
+
+struct FanOutResult
+{
+   double wall_seconds;
+   double cpu_seconds;
+   uint32_t syscalls;
+   uint32_t delivered;
+};
+
+//-------------------------------------------------------------------------------------------------------
+static uint32_t DrainReceivers( SOCKET *receivers, uint32_t count )
+{
+   char buffer[2048];
+   uint32_t received = 0;
+   for (uint32_t i = 0; i < count; ++i) {
+      while (recv( receivers[i], buffer, sizeof(buffer), 0 ) > 0) {
+         ++received;
+      }
+   }
+
+   return received;
+}
+
+//-------------------------------------------------------------------------------------------------------
+static void CloseSockets( SOCKET *socks, uint32_t count )
+{
+   for (uint32_t i = 0; i < count; ++i) {
+      if (socks[i] != INVALID_SOCKET) {
+         closesocket(socks[i]);
+      }
+   }
+}
+
+//-------------------------------------------------------------------------------------------------------
+// Only the sends are timed - draining the receivers is the receivers' cost, not ours.
+static void RunFanOut( FanOutResult *result, 
+   SOCKET sender, 
+   SOCKET *receivers, uint32_t receiver_count,
+   sockaddr_in const *targets, uint32_t target_count )
+{
+   char payload[MULTICAST_BENCH_SIZE];
+   memset( payload, 0x5a, sizeof(payload) );
+   memset( result, 0, sizeof(*result) );
+
+   for (uint32_t m = 0; m < MULTICAST_BENCH_MESSAGES; m += MULTICAST_BENCH_BATCH) {
+      double cpu_start = TimeGetThreadCPUSeconds();
+      uint64_t start = TimeGetOpCount();
+      for (uint32_t b = 0; b < MULTICAST_BENCH_BATCH; ++b) {
+         for (uint32_t t = 0; t < target_count; ++t) {
+            sendto( sender, payload, sizeof(payload), 0, (sockaddr*)&targets[t], sizeof(targets[t]) );
+            ++result->syscalls;
+         }
+      }
+      result->wall_seconds += TimeOpCountToSeconds( TimeGetOpCount() - start );
+      result->cpu_seconds += TimeGetThreadCPUSeconds() - cpu_start;
+
+      result->delivered += DrainReceivers( receivers, receiver_count );
+   }
+}
+
+//-------------------------------------------------------------------------------------------------------
+static void PrintFanOut( char const *label, uint32_t receivers, FanOutResult const &result )
+{
+   uint32_t expected = receivers * MULTICAST_BENCH_MESSAGES;
+   printf( "  %-9s %4u receivers: %7u sendto, %8.2f ms wall, %8.2f ms cpu, %.1f us cpu/msg, %u/%u delivered\n",
+      label, receivers, result.syscalls, 
+      result.wall_seconds * 1000.0, result.cpu_seconds * 1000.0,
+      result.cpu_seconds * 1e6 / MULTICAST_BENCH_MESSAGES,
+      result.delivered, expected );
+}
+
+//-------------------------------------------------------------------------------------------------------
+static void BenchMulticastForCount( uint32_t count )
+{
+   u_long non_blocking = 1;
+   sockaddr_in loopback;
+   memset( &loopback, 0, sizeof(loopback) );
+   loopback.sin_family = AF_INET;
+   inet_pton( AF_INET, "127.0.0.1", &loopback.sin_addr );
+
+   SOCKET *receivers = new SOCKET[count];
+   sockaddr_in *targets = new sockaddr_in[count];
+   FanOutResult result;
+
+   // unicast - every receiver on its own port, one sendto per receiver per message
+   SOCKET sender = socket( AF_INET, SOCK_DGRAM, IPPROTO_UDP );
+   for (uint32_t i = 0; i < count; ++i) {
+      receivers[i] = socket( AF_INET, SOCK_DGRAM, IPPROTO_UDP );
+      targets[i] = loopback;
+      targets[i].sin_port = 0;
+      bind( receivers[i], (sockaddr*)&targets[i], sizeof(targets[i]) );
+      ioctlsocket( receivers[i], FIONBIO, &non_blocking );
+
+      int len = sizeof(targets[i]);
+      getsockname( receivers[i], (sockaddr*)&targets[i], &len );
+   }
+
+   RunFanOut( &result, sender, receivers, count, targets, count );
+   PrintFanOut( "unicast", count, result );
+   CloseSockets( receivers, count );
+   closesocket(sender);
+
+   // multicast - everyone joins one group, one sendto per message
+   sockaddr_in group;
+   memset( &group, 0, sizeof(group) );
+   group.sin_family = AF_INET;
+   group.sin_port = htons(MULTICAST_BENCH_PORT);
+   inet_pton( AF_INET, MULTICAST_BENCH_GROUP, &group.sin_addr );
+
+   bool ok = true;
+   for (uint32_t i = 0; i < count; ++i) {
+      receivers[i] = MulticastCreateSocket( AF_INET, MULTICAST_BENCH_PORT, true );
+      ok = ok && (receivers[i] != INVALID_SOCKET)
+         && MulticastJoin( receivers[i], (sockaddr*)&group, (sockaddr*)&loopback )
+         && MulticastSetLoopback( receivers[i], AF_INET, true );
+      if (receivers[i] != INVALID_SOCKET) {
+         ioctlsocket( receivers[i], FIONBIO, &non_blocking );
+      }
+   }
+
+   sender = socket( AF_INET, SOCK_DGRAM, IPPROTO_UDP );
+   ok = ok && MulticastSetInterface( sender, (sockaddr*)&loopback )
+      && MulticastSetTTL( sender, AF_INET, 1 );
+
+   if (ok) {
+      RunFanOut( &result, sender, receivers, count, &group, 1 );
+      PrintFanOut( "multicast", count, result );
+   } else {
+      printf( "  multicast %4u receivers: failed to set up group on loopback.\n", count );
+   }
+
+   CloseSockets( receivers, count );
+   closesocket(sender);
+
+   delete[] targets;
+   delete[] receivers;
+}
+
+//-------------------------------------------------------------------------------------------------------
+static void BenchMulticast()
+{
+   printf( "multicast vs unicast fan-out: %u x %uB messages on loopback\n", 
+      MULTICAST_BENCH_MESSAGES, MULTICAST_BENCH_SIZE );
+
+   uint32_t counts[] = { 10, 100, 1000 };
+   for (uint32_t i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i) {
+      BenchMulticastForCount( counts[i] );
+   }
+}
+
+// MESSAGE DISPATCH /////////////////////////////////////////////////////////
+#define DISPATCH_BENCH_PACKETS      (4096)
+#define DISPATCH_BENCH_ROUNDS       (2500)
+
+template <size_t N>
+struct BenchMessage
+{
+   static constexpr uint8_t ID = (uint8_t)N;
+   uint32_t value;
+
+   bool write( MessageWriter &writer ) const { return writer.write(value); }
+   bool read( MessageReader &reader ) { return reader.read(&value); }
+};
+
+struct BenchHandler
+{
+   uint64_t sum;
+
+   template <size_t N>
+   void on_message( BenchMessage<N> const &msg ) { sum += msg.value ^ N; }
+};
+
+template <typename SEQ> struct BenchDispatcherFor;
+template <size_t... IDS> 
+struct BenchDispatcherFor<std::index_sequence<IDS...>>
+{
+   typedef MessageDispatcher<BenchHandler, BenchMessage<IDS>...> type;
+};
+
+typedef BenchDispatcherFor<std::make_index_sequence<MESSAGE_MAX_TYPES>>::type BenchDispatcher;
+
+//-------------------------------------------------------------------------------------------------------
+template <size_t N>
+static size_t WriteBenchMessageOfType( uint32_t value, uint8_t *buffer, size_t size )
+{
+   BenchMessage<N> msg;
+   msg.value = value;
+   return BenchDispatcher::write( msg, buffer, size );
+}
+
+//-------------------------------------------------------------------------------------------------------
+template <size_t... IDS>
+static size_t WriteBenchMessage( uint8_t id, uint32_t value, uint8_t *buffer, size_t size, std::index_sequence<IDS...> )
+{
+   // pick the typed writer for a runtime id - only used to build the test data
+   typedef size_t (*write_fn)( uint32_t, uint8_t*, size_t );
+   static write_fn const writers[] = { &WriteBenchMessageOfType<IDS>... };
+   return writers[id]( value, buffer, size );
+}
+
+//-------------------------------------------------------------------------------------------------------
+static void BenchDispatch()
+{
+   struct Packet
+   {
+      uint8_t data[8];
+      size_t size;
+   };
+
+   Packet *packets = new Packet[DISPATCH_BENCH_PACKETS];
+   srand(0);
+   for (uint32_t i = 0; i < DISPATCH_BENCH_PACKETS; ++i) {
+      uint8_t id = (uint8_t)(rand() % MESSAGE_MAX_TYPES);
+      packets[i].size = WriteBenchMessage( id, (uint32_t)rand(), packets[i].data, sizeof(packets[i].data), 
+         std::make_index_sequence<MESSAGE_MAX_TYPES>() );
+   }
+
+   BenchHandler handler;
+   handler.sum = 0;
+   uint32_t failed = 0;
+
+   uint64_t start = TimeGetOpCount();
+   for (uint32_t r = 0; r < DISPATCH_BENCH_ROUNDS; ++r) {
+      for (uint32_t i = 0; i < DISPATCH_BENCH_PACKETS; ++i) {
+         if (!BenchDispatcher::dispatch( handler, packets[i].data, packets[i].size )) {
+            ++failed;
+         }
+      }
+   }
+   double secs = TimeOpCountToSeconds( TimeGetOpCount() - start );
+
+   uint64_t total = (uint64_t)DISPATCH_BENCH_ROUNDS * DISPATCH_BENCH_PACKETS;
+   printf( "dispatch: %u message types, %llu messages\n", MESSAGE_MAX_TYPES, (unsigned long long)total );
+   printf( "  %.2f ns/message, %u failed (checksum %llu)\n", 
+      secs * 1e9 / (double)total, failed, (unsigned long long)handler.sum );
+
+   delete[] packets;
+}
+
+// COMPRESSION //////////////////////////////////////////////////////////////
+#define COMPRESS_BENCH_SAMPLES      (2000)
+#define COMPRESS_BENCH_ROUNDS       (50)
+#define COMPRESS_BENCH_DICTIONARY   (4 * 1024)
+
+//-------------------------------------------------------------------------------------------------------
+// Stand-in for game state traffic - a handful of entity updates per packet.
+static size_t MakeStatePacket( char *buffer, size_t buffer_size )
+{
+   static char const *states[] = { "idle", "walking", "running", "attacking", "dead" };
+
+   size_t size = 0;
+   int entities = 1 + (rand() % 6);
+   for (int i = 0; i < entities; ++i) {
+      int written = sprintf_s( buffer + size, buffer_size - size, 
+         "{\"entity\":%i,\"pos\":[%.2f,%.2f,0.00],\"vel\":[%.1f,%.1f,0.0],\"health\":%i,\"state\":\"%s\"}",
+         rand() % 500, 
+         (rand() % 20000) / 100.0f, (rand() % 20000) / 100.0f,
+         (rand() % 10) - 5.0f, (rand() % 10) - 5.0f,
+         rand() % 101, states[rand() % 5] );
+      if (written <= 0) {
+         break;
+      }
+      size += written;
+   }
+
+   return size;
+}
+
+//-------------------------------------------------------------------------------------------------------
+static void BenchCompressionWith( char const *label, PacketCompressor *compressor, 
+   char **packets, size_t *sizes )
+{
+   uint8_t out[COMPRESS_MAX_PACKET_SIZE + 16];
+   size_t raw_bytes = 0;
+   size_t compressed_bytes = 0;
+   uint32_t raw_packets = 0;
+   uint32_t failed = 0;
+
+   uint64_t compress_ops = 0;
+   uint64_t decompress_ops = 0;
+   for (uint32_t r = 0; r < COMPRESS_BENCH_ROUNDS; ++r) {
+      for (uint32_t i = 0; i < COMPRESS_BENCH_SAMPLES; ++i) {
+         uint64_t start = TimeGetOpCount();
+         size_t size = compressor->compress( out, sizeof(out), packets[i], sizes[i] );
+         uint64_t mid = TimeGetOpCount();
+
+         size_t decompressed_size = 0;
+         void const *decompressed = compressor->decompress( &decompressed_size, out, size );
+         uint64_t end = TimeGetOpCount();
+
+         compress_ops += mid - start;
+         decompress_ops += end - mid;
+
+         if ((nullptr == decompressed) 
+            || (decompressed_size != sizes[i]) 
+            || (memcmp( decompressed, packets[i], sizes[i] ) != 0)) {
+            ++failed;
+         }
+
+         if (r == 0) {
+            raw_bytes += sizes[i];
+            compressed_bytes += size;
+            raw_packets += (out[0] == COMPRESS_FLAG_RAW) ? 1 : 0;
+         }
+      }
+   }
+
+   double total_mb = (double)raw_bytes * COMPRESS_BENCH_ROUNDS / (1024.0 * 1024.0);
+   double compress_secs = TimeOpCountToSeconds(compress_ops);
+   double decompress_secs = TimeOpCountToSeconds(decompress_ops);
+   double packet_count = (double)COMPRESS_BENCH_SAMPLES * COMPRESS_BENCH_ROUNDS;
+   printf( "  %-12s ratio %.2f (%zu -> %zu B, %u sent raw), compress %.0f MB/s, decompress %.0f MB/s, +%.2f us/packet, %u failed\n",
+      label, (double)raw_bytes / (double)compressed_bytes, raw_bytes, compressed_bytes, raw_packets,
+      total_mb / compress_secs, total_mb / decompress_secs,
+      (compress_secs + decompress_secs) * 1e6 / packet_count, failed );
+}
+
+//-------------------------------------------------------------------------------------------------------
+static void BenchCompression()
+{
+   // train on one set of packets, measure on another
+   char **packets = new char*[COMPRESS_BENCH_SAMPLES * 2];
+   size_t *sizes = new size_t[COMPRESS_BENCH_SAMPLES * 2];
+   srand(0);
+   for (uint32_t i = 0; i < COMPRESS_BENCH_SAMPLES * 2; ++i) {
+      packets[i] = new char[COMPRESS_MAX_PACKET_SIZE];
+      sizes[i] = MakeStatePacket( packets[i], COMPRESS_MAX_PACKET_SIZE );
+   }
+
+   uint8_t *dictionary = new uint8_t[COMPRESS_BENCH_DICTIONARY];
+   size_t dictionary_size = CompressTrainDictionary( dictionary, COMPRESS_BENCH_DICTIONARY, 
+      (void const* const*)(packets + COMPRESS_BENCH_SAMPLES), sizes + COMPRESS_BENCH_SAMPLES, 
+      COMPRESS_BENCH_SAMPLES );
+
+   printf( "compression: %u state packets, %zuB trained dictionary\n", COMPRESS_BENCH_SAMPLES, dictionary_size );
+
+   PacketCompressor plain;
+   BenchCompressionWith( "lz", &plain, packets, sizes );
+
+   PacketCompressor with_dictionary( dictionary, dictionary_size );
+   BenchCompressionWith( "lz+dict", &with_dictionary, packets, sizes );
+
+   delete[] dictionary;
+   for (uint32_t i = 0; i < COMPRESS_BENCH_SAMPLES * 2; ++i) {
+      delete[] packets[i];
+   }
+   delete[] sizes;
+   delete[] packets;
+}
+
+// PACKET INTEGRITY /////////////////////////////////////////////////////////
+#define CRC_BENCH_BYTES             (256 * 1024 * 1024)
+#define REJECT_BENCH_PACKETS        (1000000)
+#define REJECT_BENCH_SIZE           (1200)
+
+//-------------------------------------------------------------------------------------------------------
+static double MeasureCrc( uint32_t *out_crc, uint32_t(*crc)( void const*, size_t, uint32_t ), uint8_t const *data, size_t size )
+{
+   size_t iterations = CRC_BENCH_BYTES / size;
+
+   // chain each result into the next so the calls can't overlap, and hand the
+   // last one back to be printed so the loop can't be thrown away
+   uint32_t value = 0;
+   uint64_t start = TimeGetOpCount();
+   for (size_t i = 0; i < iterations; ++i) {
+      value = crc( data, size, value );
+   }
+   double secs = TimeOpCountToSeconds( TimeGetOpCount() - start );
+
+   *out_crc = value;
+   return ((double)iterations * size) / (secs * 1024.0 * 1024.0 * 1024.0);
+}
+
+//-------------------------------------------------------------------------------------------------------
+static double MeasureOpen( uint8_t const *packet, size_t size )
+{
+   size_t payload_size;
+
+   uint64_t start = TimeGetOpCount();
+   for (uint32_t i = 0; i < REJECT_BENCH_PACKETS; ++i) {
+      PacketOpen( &payload_size, packet, size );
+   }
+   double secs = TimeOpCountToSeconds( TimeGetOpCount() - start );
+
+   return (secs * 1e9) / REJECT_BENCH_PACKETS;
+}
+
+//-------------------------------------------------------------------------------------------------------
+static void BenchIntegrity()
+{
+   static size_t const sizes[] = { 64, 512, 1400, 64 * 1024 };
+
+   uint8_t *data = new uint8_t[64 * 1024];
+   srand(0);
+   for (size_t i = 0; i < 64 * 1024; ++i) {
+      data[i] = (uint8_t)rand();
+   }
+
+   printf( "crc32c: %s\n", Crc32cIsAccelerated() ? "SSE4.2" : "table (no SSE4.2)" );
+   for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+      uint32_t fast_crc, portable_crc;
+      double fast = MeasureCrc( &fast_crc, Crc32c, data, sizes[i] );
+      double portable = MeasureCrc( &portable_crc, Crc32cPortable, data, sizes[i] );
+      printf( "  %6zuB: %6.2f GB/s, portable %6.2f GB/s (crc %08x / %08x)\n",
+         sizes[i], fast, portable, fast_crc, portable_crc );
+   }
+
+   // a good packet, then the same packet broken each way the receive path checks for
+   uint8_t packet[PACKET_HEADER_SIZE + REJECT_BENCH_SIZE];
+   memcpy( packet + PACKET_HEADER_SIZE, data, REJECT_BENCH_SIZE );
+   size_t packet_size = PacketWriteHeader( packet, REJECT_BENCH_SIZE );
+
+   PacketResetStats();
+   double accept_ns = MeasureOpen( packet, packet_size );
+
+   packet[PACKET_HEADER_SIZE + 100] ^= 0x01;
+   double bad_checksum_ns = MeasureOpen( packet, packet_size );
+   packet[PACKET_HEADER_SIZE + 100] ^= 0x01;
+
+   packet[0] ^= 0xff;
+   double bad_protocol_ns = MeasureOpen( packet, packet_size );
+   packet[0] ^= 0xff;
+
+   double too_small_ns = MeasureOpen( packet, 3 );
+
+   PacketStats const *stats = PacketGetStats();
+   printf( "packet open (%uB payload):\n", REJECT_BENCH_SIZE );
+   printf( "  accept %.1f ns, bad checksum %.1f ns, bad protocol %.1f ns, too small %.1f ns\n",
+      accept_ns, bad_checksum_ns, bad_protocol_ns, too_small_ns );
+   printf( "  stats: %llu accepted, %llu bad checksum, %llu bad protocol, %llu too small\n",
+      (unsigned long long)stats->accepted, (unsigned long long)stats->dropped_bad_checksum, 
+      (unsigned long long)stats->dropped_bad_protocol, (unsigned long long)stats->dropped_too_small );
+
+   delete[] data;
+}
+
+// BENCHMARK LIST ///////////////////////////////////////////////////////////
+static Benchmark gBenchmarks[] = {
+   { "sched", BenchScheduler },
+   { "discovery", BenchDiscovery },
+   { "multicast", BenchMulticast },
+   { "dispatch", BenchDispatch },
+   { "compress", BenchCompression },
+   { "integrity", BenchIntegrity },
+};
+
+//-------------------------------------------------------------------------------------------------------
+void RunBenchmarks( char const *name )
+{
+   size_t count = sizeof(gBenchmarks) / sizeof(gBenchmarks[0]);
+   bool ran = false;
+   for (size_t i = 0; i < count; ++i) {
+      if ((nullptr == name) || (_strcmpi( name, gBenchmarks[i].name ) == 0)) {
+         gBenchmarks[i].run();
+         ran = true;
+      }
+   }
+
+   if (!ran) {
+      printf( "Unknown benchmark [%s].\n", name );
+   }
+}
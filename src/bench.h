@@ -0,0 +1,5 @@
+#pragma once
+
+// FUNCTION PROTOTYPES //////////////////////////////////////////////////////
+// Runs the named benchmark, or all of them if name is null.
+void RunBenchmarks( char const *name );
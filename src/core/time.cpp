@@ -0,0 +1,53 @@
+#include "core/time.h"
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+// INTERNAL FUNCTIONS //////////////////////////////////////////////////////////////
+//-------------------------------------------------------------------------------------------------------
+static double GetSecondsPerOp()
+{
+   static double seconds_per_op = 0.0;
+   if (seconds_per_op == 0.0) {
+      LARGE_INTEGER freq;
+      QueryPerformanceFrequency(&freq);
+      seconds_per_op = 1.0 / (double)freq.QuadPart;
+   }
+
+   return seconds_per_op;
+}
+
+// EXTERNAL FUNCTIONS //////////////////////////////////////////////////////////////
+//-------------------------------------------------------------------------------------------------------
+uint64_t TimeGetOpCount()
+{
+   LARGE_INTEGER count;
+   QueryPerformanceCounter(&count);
+   return (uint64_t)count.QuadPart;
+}
+
+//-------------------------------------------------------------------------------------------------------
+double TimeOpCountToSeconds( uint64_t op_count )
+{
+   return (double)op_count * GetSecondsPerOp();
+}
+
+//-------------------------------------------------------------------------------------------------------
+double TimeGetSeconds()
+{
+   return TimeOpCountToSeconds( TimeGetOpCount() );
+}
+
+//-------------------------------------------------------------------------------------------------------
+double TimeGetThreadCPUSeconds()
+{
+   FILETIME creation, exit, kernel, user;
+   if (!GetThreadTimes( GetCurrentThread(), &creation, &exit, &kernel, &user )) {
+      return 0.0;
+   }
+
+   // FILETIMEs are in 100ns units; count both user and kernel (syscall) time
+   uint64_t kernel_time = ((uint64_t)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime;
+   uint64_t user_time = ((uint64_t)user.dwHighDateTime << 32) | user.dwLowDateTime;
+   return (double)(kernel_time + user_time) * 1e-7;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <stdint.h>
+
+// FUNCTION PROTOTYPES //////////////////////////////////////////////////////
+uint64_t TimeGetOpCount();
+double TimeOpCountToSeconds( uint64_t op_count );
+
+double TimeGetSeconds();
+double TimeGetThreadCPUSeconds();
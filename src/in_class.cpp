@@ -10,6 +10,12 @@
 #include <conio.h>
 #include <malloc.h>
 
+#include "net/compress.h"
+
+static size_t gMessageDictionarySize;
+static void const *gMessageDictionary = CompressGetMessageDictionary( &gMessageDictionarySize );
+static PacketCompressor gCompressor( gMessageDictionary, gMessageDictionarySize );
+
 class NetworkSystem
 {
    public:
@@ -126,9 +132,13 @@ void ServerLoop( SOCKET host_socket )
       printf( "Waiting to recv...\n" );
       int recvd = recv( their_socket, buffer, 1024, 0 );
       if (recvd > 0) {
-         buffer[recvd] = NULL;
-         printf( "Received data: %s\n", buffer );
+         size_t data_size;
+         char const *data = (char const*)gCompressor.decompress( &data_size, buffer, recvd );
+         if (nullptr != data) {
+            printf( "Received data: %.*s (%iB on the wire)\n", (int)data_size, data, recvd );
+         }
 
+         // echo back exactly what came in - it's already compressed
          printf( "Sending data...\n" );
          send( their_socket, buffer, recvd, 0 );
       }
@@ -211,7 +221,16 @@ void StartHost( char const *host_name,
 
 void ClientLoop( SOCKET host_socket, char const *msg ) 
 {
-   int sent = send( host_socket, msg, strlen(msg), 0 );
+   // leave room for the compression flag in case it has to go out raw
+   char packet[1024];
+   size_t msg_len = min( strlen(msg), (size_t)(1024 - COMPRESS_FLAG_SIZE) );
+   size_t packet_size = gCompressor.compress( packet, 1024, msg, msg_len );
+   if (packet_size == 0) {
+      printf( "Failed to write message.\n" );
+      return;
+   }
+
+   int sent = send( host_socket, packet, packet_size, 0 );
    if (sent == SOCKET_ERROR) {
       printf("Failed to send.\n");
    }
@@ -220,8 +239,11 @@ void ClientLoop( SOCKET host_socket, char const *msg )
    int recvd = recv( host_socket, buffer, 1024, 0 );
 
    if (recvd > 0) {
-      buffer[recvd] = NULL;
-      printf( "received: %s\n", buffer );
+      size_t data_size;
+      char const *data = (char const*)gCompressor.decompress( &data_size, buffer, recvd );
+      if (nullptr != data) {
+         printf( "received: %.*s\n", (int)data_size, data );
+      }
    }
 }
 
@@ -8,10 +8,96 @@
 
 #include "net/net.h"
 #include "net/addr.h"
+#include "net/discovery.h"
+#include "net/multicast.h"
+#include "net/message.h"
+#include "net/compress.h"
+#include "net/packet.h"
+#include "core/time.h"
+#include "bench.h"
 
 char const *gHostPort = "5413";
 char const *gClientPort = "5414";
 
+#define MAX_PACKET_SIZE    (2048)
+
+static size_t gMessageDictionarySize;
+static void const *gMessageDictionary = CompressGetMessageDictionary( &gMessageDictionarySize );
+static PacketCompressor gCompressor( gMessageDictionary, gMessageDictionarySize );
+
+// MESSAGES /////////////////////////////////////////////////////////////////
+struct TextMessage
+{
+   static constexpr uint8_t ID = 0;
+
+   char const *text;    // not null terminated - points into the receive buffer after a read
+   uint16_t length;
+
+   bool write( MessageWriter &writer ) const 
+   {
+      return writer.write(length) && writer.write_bytes( text, length );
+   }
+
+   bool read( MessageReader &reader ) 
+   {
+      return reader.read(&length) && reader.read_view( (void const**)&text, length );
+   }
+};
+
+class PrintMessageHandler
+{
+   public:
+      char const *from_name;
+
+      void on_message( TextMessage const &msg )
+      {
+         printf( "Received Message[%.*s] from %s\n", msg.length, msg.text, from_name );
+      }
+};
+
+typedef MessageDispatcher<PrintMessageHandler, TextMessage> PrintDispatcher;
+
+//-------------------------------------------------------------------------------------------------------
+static size_t WriteTextMessage( char *buffer, size_t buffer_size, char const *text )
+{
+   char msg_buffer[MAX_PACKET_SIZE];
+
+   TextMessage msg;
+   msg.text = text;
+   // leave room for the packet header and compression flag in case it has to go out raw
+   msg.length = (uint16_t)min( strlen(text), 
+      MAX_PACKET_SIZE - PACKET_HEADER_SIZE - COMPRESS_FLAG_SIZE - MESSAGE_ID_SIZE - sizeof(msg.length) );
+   size_t msg_size = PrintDispatcher::write( msg, msg_buffer, MAX_PACKET_SIZE );
+
+   size_t payload_size = gCompressor.compress( buffer + PACKET_HEADER_SIZE, buffer_size - PACKET_HEADER_SIZE, 
+      msg_buffer, msg_size );
+   if (payload_size == 0) {
+      return 0;
+   }
+
+   return PacketWriteHeader( buffer, payload_size );
+}
+
+//-------------------------------------------------------------------------------------------------------
+static void PrintReceivedMessage( void const *payload, size_t payload_size, char const *from_name )
+{
+   size_t msg_size;
+   void const *msg = gCompressor.decompress( &msg_size, payload, payload_size );
+
+   PrintMessageHandler handler;
+   handler.from_name = from_name;
+   if ((nullptr == msg) || !PrintDispatcher::dispatch( handler, msg, msg_size )) {
+      printf( "Dropped unrecognized %iB message from %s\n", (int)payload_size, from_name );
+   }
+
+   PacketStats const *stats = PacketGetStats();
+   uint64_t dropped = stats->dropped_too_small + stats->dropped_bad_protocol + stats->dropped_bad_checksum;
+   if (dropped > 0) {
+      printf( "(%llu packets dropped so far: %llu too small, %llu bad protocol, %llu bad checksum)\n",
+         dropped, stats->dropped_too_small, stats->dropped_bad_protocol, stats->dropped_bad_checksum );
+   }
+}
+
 
 //-------------------------------------------------------------------------------------------------------
 static std::string WindowsErrorAsString( DWORD error_id ) 
@@ -150,21 +236,50 @@ static void NetworkHost( char const *port )
    ioctlsocket( sock, FIONBIO, &non_blocking )
    */
 
+   // answer LAN discovery queries while we wait
+   char const *local_name = AllocLocalHostName();
+   DiscoveryResponder responder;
+   if (!responder.start( nullptr, DISCOVERY_PORT, (uint16_t)atoi(port), local_name )) {
+      printf( "Failed to start discovery responder.\n" );
+   }
+   FreeLocalHostName(local_name);
+
     printf( "Waiting for messages...\n" );
 
     sockaddr_storage their_addr;
-    char buffer[2048];
+    char buffer[MAX_PACKET_SIZE];
 
     for (;;) {
-      int addr_size = sizeof(their_addr);
-      int recvd = recvfrom( sock, buffer, 2048, 0, (sockaddr*)&their_addr, &addr_size );
+      // wake up for queries as soon as they land, and periodically so delayed
+      // discovery responses go out on time
+      fd_set read_set;
+      FD_ZERO( &read_set );
+      FD_SET( sock, &read_set );
+      if (responder.get_socket() != INVALID_SOCKET) {
+         FD_SET( responder.get_socket(), &read_set );
+      }
+      timeval timeout = { 0, 10000 };
+      int ready = select( 0, &read_set, nullptr, nullptr, &timeout );
 
-      char from_name[128];
-      GetAddressName( from_name, 128, (sockaddr*)&their_addr );
+      responder.update();
+      if ((ready <= 0) || !FD_ISSET( sock, &read_set )) {
+         continue;
+      }
+
+      int addr_size = sizeof(their_addr);
+      int recvd = recvfrom( sock, buffer, MAX_PACKET_SIZE, 0, (sockaddr*)&their_addr, &addr_size );
 
       if (recvd > 0) {
-         buffer[recvd] = NULL;
-         printf( "Received Message[%s] from %s\n", buffer, from_name );
+         // reject anything that isn't ours before doing any other work on it
+         size_t payload_size;
+         void const *payload = PacketOpen( &payload_size, buffer, recvd );
+         if (nullptr == payload) {
+            continue;
+         }
+
+         char from_name[128];
+         GetAddressName( from_name, 128, (sockaddr*)&their_addr );
+         PrintReceivedMessage( payload, payload_size, from_name );
       } else {
          int error = WSAGetLastError();
          printf( "recvfrom error: %i, %i\n", recvd, error );
@@ -178,14 +293,15 @@ class SpamHelper
 {
    public:
       SOCKET sock;
-      char const *msg;
+      char const *packet;
+      size_t packet_size;
 };
 
 static bool SpamMessage( addrinfo *addr, void *user_arg ) 
 {
    SpamHelper *helper = (SpamHelper*)user_arg;
 
-   int sent = sendto( helper->sock, helper->msg, strlen(helper->msg), 0, 
+   int sent = sendto( helper->sock, helper->packet, (int)helper->packet_size, 0, 
       addr->ai_addr, addr->ai_addrlen );
 
    char name[128];
@@ -210,9 +326,17 @@ static void NetworkClient( char const *target, char const *port, char const *msg
       return;
    }
    
+   char packet[MAX_PACKET_SIZE];
+
    SpamHelper helper;
    helper.sock = sock;
-   helper.msg = msg;
+   helper.packet = packet;
+   helper.packet_size = WriteTextMessage( packet, MAX_PACKET_SIZE, msg );
+   if (helper.packet_size == 0) {
+      printf( "Failed to write message.\n" );
+      closesocket( sock );
+      return;
+   }
 
    addrinfo *spam = AllocAddressesForHost( target, port, AF_UNSPEC, SOCK_DGRAM, false );
    ForEachAddress( spam, SpamMessage, &helper ); 
@@ -221,6 +345,130 @@ static void NetworkClient( char const *target, char const *port, char const *msg
    closesocket( sock );
 }
 
+//-------------------------------------------------------------------------------------------------------
+static void NetworkPublish( char const *group, char const *port, char const *msg )
+{
+   addrinfo *group_addr = AllocAddressesForHost( group, port, AF_UNSPEC, SOCK_DGRAM, false );
+   if (nullptr == group_addr) {
+      printf( "Could not resolve group [%s].\n", group );
+      return;
+   }
+
+   SOCKET sock = socket( group_addr->ai_family, SOCK_DGRAM, IPPROTO_UDP );
+   if (sock == INVALID_SOCKET) {
+      printf( "Failed to create socket. %u\n", WSAGetLastError() );
+      FreeAddresses( group_addr );
+      return;
+   }
+
+   if (!MulticastSetTTL( sock, group_addr->ai_family, 1 )) {
+      printf( "Failed to set multicast TTL. %u\n", WSAGetLastError() );
+      closesocket( sock );
+      FreeAddresses( group_addr );
+      return;
+   }
+
+   char packet[MAX_PACKET_SIZE];
+   size_t packet_size = WriteTextMessage( packet, MAX_PACKET_SIZE, msg );
+   if (packet_size == 0) {
+      printf( "Failed to write message.\n" );
+      closesocket( sock );
+      FreeAddresses( group_addr );
+      return;
+   }
+
+   // one send, however many subscribers there are
+   int sent = MulticastSend( sock, group_addr->ai_addr, (int)group_addr->ai_addrlen, packet, packet_size );
+
+   char name[128];
+   GetAddressName( name, 128, group_addr->ai_addr );
+   printf( "Published %iB message to group [%s]\n", sent, name );
+   if (sent <= 0) {
+      printf( "Error: %i\n", WSAGetLastError() );
+   }
+
+   closesocket( sock );
+   FreeAddresses( group_addr );
+}
+
+//-------------------------------------------------------------------------------------------------------
+static void NetworkSubscribe( char const *group, char const *port )
+{
+   addrinfo *group_addr = AllocAddressesForHost( group, port, AF_UNSPEC, SOCK_DGRAM, false );
+   if (nullptr == group_addr) {
+      printf( "Could not resolve group [%s].\n", group );
+      return;
+   }
+
+   SOCKET sock = MulticastCreateSocket( group_addr->ai_family, (uint16_t)atoi(port), true );
+   if ((sock == INVALID_SOCKET) 
+      || !MulticastJoin( sock, group_addr->ai_addr )
+      || !MulticastSetLoopback( sock, group_addr->ai_family, true )) {
+      printf( "Failed to join group [%s]. %i\n", group, WSAGetLastError() );
+      if (sock != INVALID_SOCKET) {
+         closesocket(sock);
+      }
+      FreeAddresses( group_addr );
+      return;
+   }
+
+   printf( "Subscribed to [%s], waiting for messages...\n", group );
+
+   sockaddr_storage their_addr;
+   char buffer[MAX_PACKET_SIZE];
+   for (;;) {
+      int addr_size = sizeof(their_addr);
+      int recvd = recvfrom( sock, buffer, MAX_PACKET_SIZE, 0, (sockaddr*)&their_addr, &addr_size );
+      if (recvd <= 0) {
+         printf( "recvfrom error: %i, %i\n", recvd, WSAGetLastError() );
+         break;
+      }
+
+      size_t payload_size;
+      void const *payload = PacketOpen( &payload_size, buffer, recvd );
+      if (nullptr == payload) {
+         continue;
+      }
+
+      char from_name[128];
+      GetAddressName( from_name, 128, (sockaddr*)&their_addr );
+      PrintReceivedMessage( payload, payload_size, from_name );
+   }
+
+   MulticastLeave( sock, group_addr->ai_addr );
+   closesocket( sock );
+   FreeAddresses( group_addr );
+}
+
+//-------------------------------------------------------------------------------------------------------
+static void NetworkDiscover( double wait_seconds )
+{
+   DiscoveryClient client;
+   if (!client.start()) {
+      printf( "Failed to start discovery client.\n" );
+      return;
+   }
+
+   client.broadcast_query( DISCOVERY_PORT );
+
+   double end_time = TimeGetSeconds() + wait_seconds;
+   while (TimeGetSeconds() < end_time) {
+      client.update();
+      Sleep(10);
+   }
+
+   uint32_t count;
+   DiscoveredHost const *hosts = client.get_hosts( &count );
+   printf( "Discovered %u host(s).\n", count );
+   for (uint32_t i = 0; i < count; ++i) {
+      char name[128];
+      GetAddressName( name, 128, (sockaddr*)&hosts[i].addr );
+      printf( "  %s [%s] game port %u, ping %.1f ms\n", 
+         hosts[i].name, name, hosts[i].game_port, hosts[i].ping_ms );
+   }
+}
+
+//-------------------------------------------------------------------------------------------------------
 static void NetworkBroadcast( char const *msg ) 
 {
    SOCKET sock = socket( PF_INET, SOCK_DGRAM, IPPROTO_UDP );
@@ -254,7 +502,15 @@ static void NetworkBroadcast( char const *msg )
    out_addr.sin_port = htons(5413);
    out_addr.sin_family = PF_INET;
 
-   int sent = sendto( sock, msg, strlen(msg), 0, (sockaddr*)&out_addr, sizeof(out_addr) );
+   char packet[MAX_PACKET_SIZE];
+   size_t packet_size = WriteTextMessage( packet, MAX_PACKET_SIZE, msg );
+   if (packet_size == 0) {
+      printf( "Failed to write message.\n" );
+      closesocket(sock);
+      return;
+   }
+
+   int sent = sendto( sock, packet, (int)packet_size, 0, (sockaddr*)&out_addr, sizeof(out_addr) );
    printf( "Broadcast message: %i sent.\n", sent );
    closesocket(sock);
 }
@@ -277,6 +533,16 @@ int main( int argc, char const **argv )
    if ((argc <= 1) || (_strcmpi( argv[1], "sock" ) == 0)) {
       printf( "Hosting...\n" );
       NetworkHost( gHostPort ); 
+   } else if (_strcmpi( argv[1], "discover" ) == 0) {
+      printf( "Discovering hosts...\n" );
+      NetworkDiscover( 1.0 );
+   } else if ((_strcmpi( argv[1], "publish" ) == 0) && (argc > 3)) {
+      printf( "Publishing message \"%s\" to group [%s]\n", argv[3], argv[2] );
+      NetworkPublish( argv[2], gHostPort, argv[3] );
+   } else if ((_strcmpi( argv[1], "subscribe" ) == 0) && (argc > 2)) {
+      NetworkSubscribe( argv[2], gHostPort );
+   } else if (_strcmpi( argv[1], "bench" ) == 0) {
+      RunBenchmarks( (argc > 2) ? argv[2] : nullptr );
    } else if (argc > 2) {
       char const *addr = argv[1];
       char const *msg = argv[2];
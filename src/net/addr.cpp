@@ -80,6 +80,27 @@ size_t GetAddressName(char *buffer, size_t const buffer_size, sockaddr const *sa
    return sprintf_s( buffer, buffer_size, "%s:%i", addr_name, port );
 }
 
+//-------------------------------------------------------------------------------------------------------
+bool AddressesEqual(sockaddr const *a, sockaddr const *b)
+{
+   if (a->sa_family != b->sa_family) {
+      return false;
+   }
+
+   if (a->sa_family == AF_INET) {
+      sockaddr_in const *a4 = (sockaddr_in const*)a;
+      sockaddr_in const *b4 = (sockaddr_in const*)b;
+      return (a4->sin_port == b4->sin_port)
+         && (memcmp(&a4->sin_addr, &b4->sin_addr, sizeof(a4->sin_addr)) == 0);
+   }
+   else {
+      sockaddr_in6 const *a6 = (sockaddr_in6 const*)a;
+      sockaddr_in6 const *b6 = (sockaddr_in6 const*)b;
+      return (a6->sin6_port == b6->sin6_port)
+         && (memcmp(&a6->sin6_addr, &b6->sin6_addr, sizeof(a6->sin6_addr)) == 0);
+   }
+}
+
 //-------------------------------------------------------------------------------------------------------
 void ForEachAddress(addrinfo *addresses, address_work_cb cb, void *user_arg)
 {
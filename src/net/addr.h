@@ -17,6 +17,7 @@ void FreeAddresses(addrinfo *addresses);
 
 uint16_t GetAddressPort(sockaddr const *addr);
 size_t GetAddressName(char *buffer, size_t const buffer_size, sockaddr const *sa);
+bool AddressesEqual(sockaddr const *a, sockaddr const *b);
 
 void ForEachAddress(addrinfo *addresses, address_work_cb cb, void *user_arg);
 
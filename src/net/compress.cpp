@@ -0,0 +1,436 @@
+#include "net/compress.h"
+
+#include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LZ_MIN_MATCH          (4)
+#define LZ_MAX_OFFSET         (0xffff)
+#define LZ_HASH_BITS          (12)
+#define LZ_HASH_SIZE          (1 << LZ_HASH_BITS)
+#define LZ_MIN_PACKET_SIZE    (8)         // anything smaller can't win back the header
+
+#define TRAIN_GRAM_SIZE       (8)
+#define TRAIN_SEGMENT_SIZE    (32)
+#define TRAIN_COUNT_BITS      (16)
+#define TRAIN_SEEN_BITS       (12)
+
+// INTERNAL FUNCTIONS //////////////////////////////////////////////////////////////
+//-------------------------------------------------------------------------------------------------------
+static uint32_t Read32( uint8_t const *ptr )
+{
+   uint32_t v;
+   memcpy( &v, ptr, sizeof(v) );
+   return v;
+}
+
+//-------------------------------------------------------------------------------------------------------
+static uint32_t HashLZ( uint8_t const *ptr )
+{
+   return (Read32(ptr) * 2654435761U) >> (32 - LZ_HASH_BITS);
+}
+
+//-------------------------------------------------------------------------------------------------------
+static uint8_t* WriteLength( uint8_t *op, size_t length )
+{
+   while (length >= 255) {
+      *op++ = 255;
+      length -= 255;
+   }
+   *op++ = (uint8_t)length;
+   return op;
+}
+
+//-------------------------------------------------------------------------------------------------------
+static bool ReadLength( size_t *length, uint8_t const **ip, uint8_t const *iend )
+{
+   uint8_t b;
+   do {
+      if (*ip >= iend) {
+         return false;
+      }
+      b = *(*ip)++;
+      *length += b;
+   } while (b == 255);
+
+   return true;
+}
+
+//-------------------------------------------------------------------------------------------------------
+// Writes one sequence - literals followed by a match (or just literals when match_length is 0,
+// which is only allowed for the last sequence).  Returns nullptr if it won't fit.
+static uint8_t* WriteSequence( uint8_t *op, uint8_t const *oend, 
+   uint8_t const *literals, size_t literal_length, 
+   size_t offset, size_t match_length )
+{
+   size_t worst_case = 1 + (literal_length / 255) + 1 + literal_length + 2 + (match_length / 255) + 1;
+   if ((op + worst_case) > oend) {
+      return nullptr;
+   }
+
+   size_t match_code = (match_length > 0) ? (match_length - LZ_MIN_MATCH) : 0;
+   uint8_t *token = op++;
+   *token = (uint8_t)(((literal_length < 15) ? literal_length : 15) << 4)
+      | (uint8_t)((match_code < 15) ? match_code : 15);
+
+   if (literal_length >= 15) {
+      op = WriteLength( op, literal_length - 15 );
+   }
+   memcpy( op, literals, literal_length );
+   op += literal_length;
+
+   if (match_length > 0) {
+      uint16_t offset16 = (uint16_t)offset;
+      memcpy( op, &offset16, sizeof(offset16) );
+      op += sizeof(offset16);
+
+      if (match_code >= 15) {
+         op = WriteLength( op, match_code - 15 );
+      }
+   }
+
+   return op;
+}
+
+//-------------------------------------------------------------------------------------------------------
+// Greedy LZ over window[start, end), matching back into the dictionary in front of it.
+// Returns compressed size, or 0 if it would need more than dst_capacity.
+static size_t CompressLZ( uint8_t *dst, size_t dst_capacity, 
+   uint8_t const *window, size_t start, size_t end, 
+   uint16_t *hash_table )
+{
+   uint8_t *op = dst;
+   uint8_t const *oend = dst + dst_capacity;
+
+   size_t ip = start;
+   size_t anchor = start;
+   while ((ip + LZ_MIN_MATCH) <= end) {
+      uint32_t h = HashLZ( window + ip );
+      size_t ref = hash_table[h];
+      hash_table[h] = (uint16_t)ip;
+
+      // the table is only a hint - confirm the bytes actually match
+      if ((ref >= ip) 
+         || ((ip - ref) > LZ_MAX_OFFSET)
+         || (Read32( window + ref ) != Read32( window + ip ))) {
+         ++ip;
+         continue;
+      }
+
+      size_t length = LZ_MIN_MATCH;
+      while (((ip + length) < end) && (window[ref + length] == window[ip + length])) {
+         ++length;
+      }
+
+      op = WriteSequence( op, oend, window + anchor, ip - anchor, ip - ref, length );
+      if (nullptr == op) {
+         return 0;
+      }
+
+      ip += length;
+      anchor = ip;
+   }
+
+   op = WriteSequence( op, oend, window + anchor, end - anchor, 0, 0 );
+   if (nullptr == op) {
+      return 0;
+   }
+
+   return op - dst;
+}
+
+//-------------------------------------------------------------------------------------------------------
+static uint64_t HashGram( uint8_t const *ptr )
+{
+   uint64_t v;
+   memcpy( &v, ptr, sizeof(v) );
+   return v * 0x9E3779B97F4A7C15ULL;
+}
+
+// EXTERNAL FUNCTIONS //////////////////////////////////////////////////////////////
+//-------------------------------------------------------------------------------------------------------
+PacketCompressor::PacketCompressor( void const *dictionary, size_t size )
+{
+   if ((nullptr == dictionary) || (size > COMPRESS_MAX_DICTIONARY_SIZE)) {
+      size = 0;
+   }
+
+   enabled = true;
+   dictionary_size = size;
+   window = (uint8_t*)malloc( dictionary_size + COMPRESS_MAX_PACKET_SIZE );
+   hash_table = (uint16_t*)malloc( LZ_HASH_SIZE * sizeof(uint16_t) );
+   dictionary_hash_table = (uint16_t*)malloc( LZ_HASH_SIZE * sizeof(uint16_t) );
+   decompress_buffer = (uint8_t*)malloc( COMPRESS_MAX_PACKET_SIZE );
+
+   // hash the dictionary once; every packet starts from this table
+   memset( dictionary_hash_table, 0, LZ_HASH_SIZE * sizeof(uint16_t) );
+   if (dictionary_size > 0) {
+      memcpy( window, dictionary, dictionary_size );
+      for (size_t i = 0; (i + LZ_MIN_MATCH) <= dictionary_size; ++i) {
+         dictionary_hash_table[HashLZ( window + i )] = (uint16_t)i;
+      }
+   }
+}
+
+//-------------------------------------------------------------------------------------------------------
+PacketCompressor::~PacketCompressor()
+{
+   free( window );
+   free( hash_table );
+   free( dictionary_hash_table );
+   free( decompress_buffer );
+}
+
+//-------------------------------------------------------------------------------------------------------
+size_t PacketCompressor::compress( void *out, size_t out_capacity, void const *src, size_t src_size )
+{
+   uint8_t *dst = (uint8_t*)out;
+   if ((src_size > COMPRESS_MAX_PACKET_SIZE) || (out_capacity < 1)) {
+      return 0;
+   }
+
+   size_t const lz_header_size = 1 + sizeof(uint16_t);
+   if (enabled && (src_size >= LZ_MIN_PACKET_SIZE) && (out_capacity > lz_header_size)) {
+      memcpy( window + dictionary_size, src, src_size );
+      memcpy( hash_table, dictionary_hash_table, LZ_HASH_SIZE * sizeof(uint16_t) );
+
+      // only worth it if it comes out smaller than sending raw
+      size_t capacity = out_capacity - lz_header_size;
+      if (capacity > (src_size - lz_header_size)) {
+         capacity = src_size - lz_header_size;
+      }
+
+      size_t size = CompressLZ( dst + lz_header_size, capacity, 
+         window, dictionary_size, dictionary_size + src_size, 
+         hash_table );
+      if (size > 0) {
+         uint16_t raw_size = (uint16_t)src_size;
+         dst[0] = COMPRESS_FLAG_LZ;
+         memcpy( dst + 1, &raw_size, sizeof(raw_size) );
+         return lz_header_size + size;
+      }
+   }
+
+   if ((1 + src_size) > out_capacity) {
+      return 0;
+   }
+
+   dst[0] = COMPRESS_FLAG_RAW;
+   memcpy( dst + 1, src, src_size );
+   return 1 + src_size;
+}
+
+//-------------------------------------------------------------------------------------------------------
+void const* PacketCompressor::decompress( size_t *out_size, void const *src, size_t src_size )
+{
+   uint8_t const *ip = (uint8_t const*)src;
+   uint8_t const *iend = ip + src_size;
+   if (src_size < 1) {
+      return nullptr;
+   }
+
+   uint8_t flag = *ip++;
+   if (flag == COMPRESS_FLAG_RAW) {
+      *out_size = src_size - 1;
+      return ip;
+   } else if ((flag != COMPRESS_FLAG_LZ) || (src_size < 3)) {
+      return nullptr;
+   }
+
+   uint16_t raw_size;
+   memcpy( &raw_size, ip, sizeof(raw_size) );
+   ip += sizeof(raw_size);
+   if (raw_size > COMPRESS_MAX_PACKET_SIZE) {
+      return nullptr;
+   }
+
+   uint8_t *const ostart = decompress_buffer;
+   uint8_t *const oend = ostart + raw_size;
+   uint8_t *op = ostart;
+
+   for (;;) {
+      if (ip >= iend) {
+         return nullptr;
+      }
+
+      uint8_t token = *ip++;
+      size_t literal_length = token >> 4;
+      if ((literal_length == 15) && !ReadLength( &literal_length, &ip, iend )) {
+         return nullptr;
+      }
+
+      if ((literal_length > (size_t)(iend - ip)) || (literal_length > (size_t)(oend - op))) {
+         return nullptr;
+      }
+
+      memcpy( op, ip, literal_length );
+      op += literal_length;
+      ip += literal_length;
+
+      // last sequence has no match
+      if (ip == iend) {
+         break;
+      }
+
+      if ((iend - ip) < 2) {
+         return nullptr;
+      }
+
+      uint16_t offset;
+      memcpy( &offset, ip, sizeof(offset) );
+      ip += sizeof(offset);
+
+      size_t match_length = token & 15;
+      if ((match_length == 15) && !ReadLength( &match_length, &ip, iend )) {
+         return nullptr;
+      }
+      match_length += LZ_MIN_MATCH;
+
+      size_t produced = op - ostart;
+      if ((offset == 0) 
+         || (offset > (produced + dictionary_size)) 
+         || (match_length > (size_t)(oend - op))) {
+         return nullptr;
+      }
+
+      // match may start back in the dictionary and run into this packet
+      if (offset > produced) {
+         size_t back = offset - produced;
+         size_t from_dictionary = (match_length < back) ? match_length : back;
+         memcpy( op, window + dictionary_size - back, from_dictionary );
+         op += from_dictionary;
+         match_length -= from_dictionary;
+
+         uint8_t const *match = ostart;
+         while (match_length > 0) {
+            *op++ = *match++;
+            --match_length;
+         }
+      } else if (offset >= match_length) {
+         memcpy( op, op - offset, match_length );
+         op += match_length;
+      } else {
+         // overlapping copy repeats the last few bytes
+         uint8_t const *match = op - offset;
+         while (match_length > 0) {
+            *op++ = *match++;
+            --match_length;
+         }
+      }
+   }
+
+   if (op != oend) {
+      return nullptr;
+   }
+
+   *out_size = raw_size;
+   return ostart;
+}
+
+//-------------------------------------------------------------------------------------------------------
+struct TrainSegment
+{
+   uint8_t const *data;
+   size_t size;
+   uint64_t score;
+};
+
+//-------------------------------------------------------------------------------------------------------
+static int CompareSegmentScore( void const *a, void const *b )
+{
+   uint64_t score_a = ((TrainSegment const*)a)->score;
+   uint64_t score_b = ((TrainSegment const*)b)->score;
+   return (score_a < score_b) ? 1 : ((score_a > score_b) ? -1 : 0);
+}
+
+//-------------------------------------------------------------------------------------------------------
+size_t CompressTrainDictionary( void *out, size_t out_capacity, 
+   void const *const *samples, size_t const *sample_sizes, size_t sample_count )
+{
+   if (out_capacity > COMPRESS_MAX_DICTIONARY_SIZE) {
+      out_capacity = COMPRESS_MAX_DICTIONARY_SIZE;
+   }
+
+   // how often does each short run of bytes show up across all samples
+   size_t const count_size = (size_t)1 << TRAIN_COUNT_BITS;
+   uint16_t *counts = (uint16_t*)calloc( count_size, sizeof(uint16_t) );
+   size_t segment_count = 0;
+   for (size_t s = 0; s < sample_count; ++s) {
+      uint8_t const *sample = (uint8_t const*)samples[s];
+      for (size_t i = 0; (i + TRAIN_GRAM_SIZE) <= sample_sizes[s]; ++i) {
+         uint16_t *count = &counts[HashGram( sample + i ) >> (64 - TRAIN_COUNT_BITS)];
+         if (*count < 0xffff) {
+            ++(*count);
+         }
+      }
+      segment_count += (sample_sizes[s] + TRAIN_SEGMENT_SIZE - 1) / TRAIN_SEGMENT_SIZE;
+   }
+
+   // score fixed size segments by how common their contents are
+   TrainSegment *segments = (TrainSegment*)malloc( (segment_count + 1) * sizeof(TrainSegment) );
+   segment_count = 0;
+   for (size_t s = 0; s < sample_count; ++s) {
+      uint8_t const *sample = (uint8_t const*)samples[s];
+      for (size_t start = 0; (start + TRAIN_GRAM_SIZE) <= sample_sizes[s]; start += TRAIN_SEGMENT_SIZE) {
+         TrainSegment *segment = &segments[segment_count++];
+         segment->data = sample + start;
+         segment->size = sample_sizes[s] - start;
+         if (segment->size > TRAIN_SEGMENT_SIZE) {
+            segment->size = TRAIN_SEGMENT_SIZE;
+         }
+
+         segment->score = 0;
+         for (size_t i = start; ((i + TRAIN_GRAM_SIZE) <= sample_sizes[s]) && (i < (start + segment->size)); ++i) {
+            segment->score += counts[HashGram( sample + i ) >> (64 - TRAIN_COUNT_BITS)] - 1;
+         }
+      }
+   }
+
+   qsort( segments, segment_count, sizeof(TrainSegment), CompareSegmentScore );
+
+   // take the best, skipping repeats.  Best ends up last so it's the cheapest offset to reach.
+   size_t const seen_size = (size_t)1 << TRAIN_SEEN_BITS;
+   uint64_t *seen = (uint64_t*)calloc( seen_size, sizeof(uint64_t) );
+   uint8_t *dst = (uint8_t*)out;
+   size_t used = 0;
+   for (size_t i = 0; (i < segment_count) && (segments[i].score > 0); ++i) {
+      TrainSegment const *segment = &segments[i];
+      if ((used + segment->size) > out_capacity) {
+         continue;
+      }
+
+      uint64_t hash = 1469598103934665603ULL;
+      for (size_t b = 0; b < segment->size; ++b) {
+         hash = (hash ^ segment->data[b]) * 1099511628211ULL;
+      }
+      hash |= 1;
+
+      size_t slot = hash >> (64 - TRAIN_SEEN_BITS);
+      bool duplicate = false;
+      for (size_t probe = 0; probe < seen_size; ++probe) {
+         uint64_t *entry = &seen[(slot + probe) & (seen_size - 1)];
+         if (*entry == hash) {
+            duplicate = true;
+            break;
+         } else if (*entry == 0) {
+            *entry = hash;
+            break;
+         }
+      }
+
+      if (duplicate) {
+         continue;
+      }
+
+      used += segment->size;
+      memcpy( dst + out_capacity - used, segment->data, segment->size );
+   }
+
+   // slide everything down to the front
+   memmove( dst, dst + out_capacity - used, used );
+
+   free( seen );
+   free( segments );
+   free( counts );
+   return used;
+}
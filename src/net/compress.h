@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// DEFINES //////////////////////////////////////////////////////////////////
+#define COMPRESS_MAX_PACKET_SIZE       (2048)
+#define COMPRESS_MAX_DICTIONARY_SIZE   (16 * 1024)
+
+// Every packet through the compression stage starts with a one byte flag
+//    raw:        [COMPRESS_FLAG_RAW][payload]
+//    compressed: [COMPRESS_FLAG_LZ][payload size (2B)][lz sequences]
+#define COMPRESS_FLAG_RAW              (0)
+#define COMPRESS_FLAG_LZ               (1)
+#define COMPRESS_FLAG_SIZE             (1)
+
+// TYPES ////////////////////////////////////////////////////////////////////
+// Fast LZ77 (LZ4 style) packet compressor.  A shared dictionary acts as history
+// in front of every packet, so even small packets can match against it - both
+// ends must be created with the same dictionary.  All buffers are allocated up
+// front; compress/decompress never allocate.
+class PacketCompressor
+{
+   public:
+      PacketCompressor( void const *dictionary = nullptr, size_t dictionary_size = 0 );
+      ~PacketCompressor();
+
+      // Writes a flagged packet to out, falling back to raw when compression 
+      // doesn't make it smaller.  Returns 0 if it doesn't fit.
+      size_t compress( void *out, size_t out_capacity, void const *src, size_t src_size );
+
+      // Returns the payload (owned by the compressor, valid until the next call),
+      // or nullptr if the packet is malformed.
+      void const* decompress( size_t *out_size, void const *src, size_t src_size );
+
+   public:
+      bool enabled;     // when false, compress() always sends raw
+
+   private:
+      PacketCompressor( PacketCompressor const& );
+      PacketCompressor& operator=( PacketCompressor const& );
+
+   private:
+      // [dictionary][packet being compressed]
+      uint8_t *window;
+      size_t dictionary_size;
+
+      uint16_t *hash_table;
+      uint16_t *dictionary_hash_table;
+
+      uint8_t *decompress_buffer;
+};
+
+// FUNCTION PROTOTYPES //////////////////////////////////////////////////////
+// Builds a dictionary from sample packets by keeping the segments whose
+// contents show up most often across all samples.  Returns the dictionary size.
+size_t CompressTrainDictionary( void *out, size_t out_capacity, 
+   void const *const *samples, size_t const *sample_sizes, size_t sample_count );
+
+// The static dictionary text messages are compressed with - both ends of a
+// connection must use it.
+void const* CompressGetMessageDictionary( size_t *out_size );
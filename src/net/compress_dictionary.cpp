@@ -0,0 +1,16 @@
+#include "net/compress.h"
+
+// Static dictionary shared by every sender and receiver.  Short text messages
+// rarely repeat within themselves, but they do repeat these.
+static char const gMessageDictionary[] =
+   "hello world test message from the client to the host server "
+   "player joined left the game ready start round over score "
+   "position velocity health state idle walking running attacking dead "
+   "ping pong ack sync update entity spawn destroy chat team red blue ";
+
+//-------------------------------------------------------------------------------------------------------
+void const* CompressGetMessageDictionary( size_t *out_size )
+{
+   *out_size = sizeof(gMessageDictionary) - 1;
+   return gMessageDictionary;
+}
@@ -0,0 +1,428 @@
+#include "net/discovery.h"
+#include "net/addr.h"
+#include "core/time.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define DISCOVERY_HEADER_SIZE          (16)
+#define DISCOVERY_RESPONSE_SIZE        (DISCOVERY_HEADER_SIZE + 5)    // held_us(4) name_len(1)
+#define DISCOVERY_MAX_PACKET_SIZE      (DISCOVERY_RESPONSE_SIZE + DISCOVERY_MAX_NAME)
+
+// INTERNAL FUNCTIONS //////////////////////////////////////////////////////////////
+//-------------------------------------------------------------------------------------------------------
+// wraps every ~71 minutes, which is fine since it's only ever used for differences
+static uint32_t GetTimeUS()
+{
+   return (uint32_t)(uint64_t)(TimeGetSeconds() * 1000000.0);
+}
+
+//-------------------------------------------------------------------------------------------------------
+static float GetRandomZeroToOne()
+{
+   return (float)rand() / (float)RAND_MAX;
+}
+
+//-------------------------------------------------------------------------------------------------------
+static SOCKET CreateDiscoverySocket( char const *ip, uint16_t port, bool broadcast )
+{
+   SOCKET sock = socket( AF_INET, SOCK_DGRAM, IPPROTO_UDP );
+   if (sock == INVALID_SOCKET) {
+      return INVALID_SOCKET;
+   }
+
+   sockaddr_in addr;
+   memset( &addr, 0, sizeof(addr) );
+   addr.sin_family = AF_INET;
+   addr.sin_port = htons(port);
+   if (nullptr == ip) {
+      addr.sin_addr.s_addr = htonl(INADDR_ANY);
+   } else {
+      inet_pton( AF_INET, ip, &addr.sin_addr );
+   }
+
+   if (broadcast) {
+      int enable = 1;
+      setsockopt( sock, SOL_SOCKET, SO_BROADCAST, (char*)&enable, sizeof(enable) );
+   }
+
+   u_long non_blocking = 1;
+   if ((bind( sock, (sockaddr*)&addr, sizeof(addr) ) == SOCKET_ERROR)
+      || (ioctlsocket( sock, FIONBIO, &non_blocking ) == SOCKET_ERROR)) {
+      closesocket(sock);
+      return INVALID_SOCKET;
+   }
+
+   return sock;
+}
+
+//-------------------------------------------------------------------------------------------------------
+static void WriteU16( uint8_t *buffer, uint16_t v )   { memcpy( buffer, &v, sizeof(v) ); }
+static void WriteU32( uint8_t *buffer, uint32_t v )   { memcpy( buffer, &v, sizeof(v) ); }
+static uint16_t ReadU16( uint8_t const *buffer )      { uint16_t v; memcpy( &v, buffer, sizeof(v) ); return v; }
+static uint32_t ReadU32( uint8_t const *buffer )      { uint32_t v; memcpy( &v, buffer, sizeof(v) ); return v; }
+
+// EXTERNAL FUNCTIONS //////////////////////////////////////////////////////////////
+//-------------------------------------------------------------------------------------------------------
+size_t DiscoveryWritePacket( uint8_t *buffer, size_t buffer_size, DiscoveryPacket const &packet )
+{
+   size_t name_len = 0;
+   if (packet.type == DISCOVERY_RESPONSE) {
+      name_len = strnlen( packet.name, DISCOVERY_MAX_NAME - 1 );
+   }
+
+   size_t size = (packet.type == DISCOVERY_RESPONSE) ? (DISCOVERY_RESPONSE_SIZE + name_len) : DISCOVERY_HEADER_SIZE;
+   if (size > buffer_size) {
+      return 0;
+   }
+
+   WriteU32( buffer + 0, DISCOVERY_MAGIC );
+   buffer[4] = DISCOVERY_VERSION;
+   buffer[5] = packet.type;
+   WriteU16( buffer + 6, packet.game_port );
+   WriteU32( buffer + 8, packet.nonce );
+   WriteU32( buffer + 12, packet.time_us );
+
+   if (packet.type == DISCOVERY_RESPONSE) {
+      WriteU32( buffer + DISCOVERY_HEADER_SIZE, packet.held_us );
+      buffer[DISCOVERY_HEADER_SIZE + 4] = (uint8_t)name_len;
+      memcpy( buffer + DISCOVERY_RESPONSE_SIZE, packet.name, name_len );
+   }
+
+   return size;
+}
+
+//-------------------------------------------------------------------------------------------------------
+bool DiscoveryReadPacket( DiscoveryPacket *out, uint8_t const *buffer, size_t size )
+{
+   if ((size < DISCOVERY_HEADER_SIZE)
+      || (ReadU32(buffer) != DISCOVERY_MAGIC)
+      || (buffer[4] != DISCOVERY_VERSION)) {
+      return false;
+   }
+
+   out->type = buffer[5];
+   out->game_port = ReadU16( buffer + 6 );
+   out->nonce = ReadU32( buffer + 8 );
+   out->time_us = ReadU32( buffer + 12 );
+   out->held_us = 0;
+   out->name[0] = '\0';
+
+   if (out->type == DISCOVERY_RESPONSE) {
+      if (size < DISCOVERY_RESPONSE_SIZE) {
+         return false;
+      }
+
+      out->held_us = ReadU32( buffer + DISCOVERY_HEADER_SIZE );
+      size_t name_len = buffer[DISCOVERY_HEADER_SIZE + 4];
+      if ((name_len >= DISCOVERY_MAX_NAME) || ((DISCOVERY_RESPONSE_SIZE + name_len) > size)) {
+         return false;
+      }
+
+      memcpy( out->name, buffer + DISCOVERY_RESPONSE_SIZE, name_len );
+      out->name[name_len] = '\0';
+   } else if (out->type != DISCOVERY_QUERY) {
+      return false;
+   }
+
+   return true;
+}
+
+// DISCOVERY RESPONDER //////////////////////////////////////////////////////
+//-------------------------------------------------------------------------------------------------------
+DiscoveryResponder::DiscoveryResponder()
+{
+   max_delay = DISCOVERY_DEFAULT_MAX_DELAY;
+   sock = INVALID_SOCKET;
+   game_port = 0;
+   name[0] = '\0';
+   pending_count = 0;
+}
+
+//-------------------------------------------------------------------------------------------------------
+DiscoveryResponder::~DiscoveryResponder()
+{
+   stop();
+}
+
+//-------------------------------------------------------------------------------------------------------
+bool DiscoveryResponder::start( char const *ip, uint16_t port, uint16_t port_for_game, char const *host_name )
+{
+   stop();
+
+   sock = CreateDiscoverySocket( ip, port, false );
+   if (sock == INVALID_SOCKET) {
+      return false;
+   }
+
+   game_port = port_for_game;
+   strncpy_s( name, DISCOVERY_MAX_NAME, (nullptr != host_name) ? host_name : "", _TRUNCATE );
+   pending_count = 0;
+   return true;
+}
+
+//-------------------------------------------------------------------------------------------------------
+void DiscoveryResponder::stop()
+{
+   if (sock != INVALID_SOCKET) {
+      closesocket(sock);
+      sock = INVALID_SOCKET;
+   }
+}
+
+//-------------------------------------------------------------------------------------------------------
+void DiscoveryResponder::update()
+{
+   if (sock == INVALID_SOCKET) {
+      return;
+   }
+
+   uint8_t buffer[DISCOVERY_MAX_PACKET_SIZE];
+
+   // queue up a delayed response for every query waiting on the socket
+   for (;;) {
+      sockaddr_storage from;
+      int from_len = sizeof(from);
+      int recvd = recvfrom( sock, (char*)buffer, sizeof(buffer), 0, (sockaddr*)&from, &from_len );
+      if (recvd <= 0) {
+         break;
+      }
+
+      DiscoveryPacket query;
+      if (!DiscoveryReadPacket( &query, buffer, recvd ) || (query.type != DISCOVERY_QUERY)) {
+         continue;
+      }
+
+      if (pending_count >= DISCOVERY_MAX_PENDING) {
+         continue;
+      }
+
+      // stamp each query as it comes off the socket so the hold time covers everything after it
+      double received_at = TimeGetSeconds();
+      PendingResponse *response = &pending[pending_count];
+      memcpy( &response->to, &from, from_len );
+      response->to_len = from_len;
+      response->nonce = query.nonce;
+      response->time_us = query.time_us;
+      response->received_at = received_at;
+      response->send_at = received_at + (max_delay * GetRandomZeroToOne());
+      ++pending_count;
+   }
+
+   // send anything whose delay is up
+   double now = TimeGetSeconds();
+   DiscoveryPacket packet;
+   packet.type = DISCOVERY_RESPONSE;
+   packet.game_port = game_port;
+   memcpy( packet.name, name, sizeof(name) );
+
+   uint32_t i = 0;
+   while (i < pending_count) {
+      PendingResponse *response = &pending[i];
+      if (response->send_at > now) {
+         ++i;
+         continue;
+      }
+
+      // echo the asker's time back so they can measure ping off their own clock
+      packet.nonce = response->nonce;
+      packet.time_us = response->time_us;
+      packet.held_us = (uint32_t)((TimeGetSeconds() - response->received_at) * 1000000.0);
+      size_t size = DiscoveryWritePacket( buffer, sizeof(buffer), packet );
+      sendto( sock, (char*)buffer, (int)size, 0, (sockaddr*)&response->to, response->to_len );
+
+      --pending_count;
+      pending[i] = pending[pending_count];
+   }
+}
+
+//-------------------------------------------------------------------------------------------------------
+uint16_t DiscoveryResponder::get_port() const
+{
+   sockaddr_storage addr;
+   int addr_len = sizeof(addr);
+   if (getsockname( sock, (sockaddr*)&addr, &addr_len ) == SOCKET_ERROR) {
+      return 0;
+   }
+
+   return GetAddressPort( (sockaddr*)&addr );
+}
+
+//-------------------------------------------------------------------------------------------------------
+SOCKET DiscoveryResponder::get_socket() const
+{
+   return sock;
+}
+
+// DISCOVERY CLIENT /////////////////////////////////////////////////////////
+//-------------------------------------------------------------------------------------------------------
+DiscoveryClient::DiscoveryClient()
+{
+   ttl = DISCOVERY_DEFAULT_TTL;
+   sock = INVALID_SOCKET;
+   nonce = 0;
+   host_count = 0;
+}
+
+//-------------------------------------------------------------------------------------------------------
+DiscoveryClient::~DiscoveryClient()
+{
+   stop();
+}
+
+//-------------------------------------------------------------------------------------------------------
+bool DiscoveryClient::start()
+{
+   stop();
+
+   sock = CreateDiscoverySocket( nullptr, 0, true );
+   if (sock == INVALID_SOCKET) {
+      return false;
+   }
+
+   // unique per client - mix the high resolution clock with our ephemeral port
+   sockaddr_storage addr;
+   int addr_len = sizeof(addr);
+   uint16_t port = 0;
+   if (getsockname( sock, (sockaddr*)&addr, &addr_len ) != SOCKET_ERROR) {
+      port = GetAddressPort( (sockaddr*)&addr );
+   }
+
+   uint64_t seed = (TimeGetOpCount() ^ ((uint64_t)port << 48)) * 0x9E3779B97F4A7C15ULL;
+   nonce = (uint32_t)(seed >> 32);
+   return true;
+}
+
+//-------------------------------------------------------------------------------------------------------
+void DiscoveryClient::stop()
+{
+   if (sock != INVALID_SOCKET) {
+      closesocket(sock);
+      sock = INVALID_SOCKET;
+   }
+}
+
+//-------------------------------------------------------------------------------------------------------
+void DiscoveryClient::update()
+{
+   if (sock == INVALID_SOCKET) {
+      return;
+   }
+
+   double now = TimeGetSeconds();
+   uint8_t buffer[DISCOVERY_MAX_PACKET_SIZE];
+
+   for (;;) {
+      sockaddr_storage from;
+      int from_len = sizeof(from);
+      int recvd = recvfrom( sock, (char*)buffer, sizeof(buffer), 0, (sockaddr*)&from, &from_len );
+      if (recvd <= 0) {
+         break;
+      }
+
+      DiscoveryPacket packet;
+      if (DiscoveryReadPacket( &packet, buffer, recvd ) 
+         && (packet.type == DISCOVERY_RESPONSE)
+         && (packet.nonce == nonce)) {
+         cache_response( packet, (sockaddr*)&from, from_len, now );
+      }
+   }
+
+   // expire anyone we haven't heard from in a while
+   uint32_t i = 0;
+   while (i < host_count) {
+      if ((now - hosts[i].last_seen) > ttl) {
+         --host_count;
+         hosts[i] = hosts[host_count];
+      } else {
+         ++i;
+      }
+   }
+}
+
+//-------------------------------------------------------------------------------------------------------
+bool DiscoveryClient::broadcast_query( uint16_t port )
+{
+   sockaddr_in addr;
+   memset( &addr, 0, sizeof(addr) );
+   addr.sin_family = AF_INET;
+   addr.sin_port = htons(port);
+   addr.sin_addr.s_addr = htonl(INADDR_BROADCAST);
+
+   return send_query( (sockaddr*)&addr, sizeof(addr) );
+}
+
+//-------------------------------------------------------------------------------------------------------
+bool DiscoveryClient::send_query( sockaddr const *addr, int addr_len )
+{
+   if (sock == INVALID_SOCKET) {
+      return false;
+   }
+
+   DiscoveryPacket packet;
+   packet.type = DISCOVERY_QUERY;
+   packet.game_port = 0;
+   packet.nonce = nonce;
+   packet.time_us = GetTimeUS();
+   packet.held_us = 0;
+
+   uint8_t buffer[DISCOVERY_MAX_PACKET_SIZE];
+   size_t size = DiscoveryWritePacket( buffer, sizeof(buffer), packet );
+   int sent = sendto( sock, (char*)buffer, (int)size, 0, addr, addr_len );
+   return (sent == (int)size);
+}
+
+//-------------------------------------------------------------------------------------------------------
+DiscoveredHost const* DiscoveryClient::get_hosts( uint32_t *out_count ) const
+{
+   *out_count = host_count;
+   return hosts;
+}
+
+//-------------------------------------------------------------------------------------------------------
+DiscoveredHost const* DiscoveryClient::find_host( char const *host_name ) const
+{
+   for (uint32_t i = 0; i < host_count; ++i) {
+      if (strcmp( hosts[i].name, host_name ) == 0) {
+         return &hosts[i];
+      }
+   }
+
+   return nullptr;
+}
+
+//-------------------------------------------------------------------------------------------------------
+void DiscoveryClient::clear()
+{
+   host_count = 0;
+}
+
+//-------------------------------------------------------------------------------------------------------
+void DiscoveryClient::cache_response( DiscoveryPacket const &packet, sockaddr const *from, int from_len, double now )
+{
+   DiscoveredHost *host = nullptr;
+   for (uint32_t i = 0; i < host_count; ++i) {
+      if (AddressesEqual( (sockaddr*)&hosts[i].addr, from )) {
+         host = &hosts[i];
+         break;
+      }
+   }
+
+   if (nullptr == host) {
+      if (host_count >= DISCOVERY_MAX_HOSTS) {
+         return;
+      }
+
+      host = &hosts[host_count];
+      ++host_count;
+   }
+
+   memcpy( &host->addr, from, from_len );
+   host->addr_len = from_len;
+   host->game_port = packet.game_port;
+   memcpy( host->name, packet.name, sizeof(host->name) );
+   // don't count the time the responder deliberately held the reply back
+   int32_t round_trip_us = (int32_t)(GetTimeUS() - packet.time_us - packet.held_us);
+   host->ping_ms = (float)((round_trip_us > 0) ? round_trip_us : 0) / 1000.0f;
+   host->last_seen = now;
+}
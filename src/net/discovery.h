@@ -0,0 +1,122 @@
+#pragma once
+
+#include "net/net.h"
+
+// DEFINES //////////////////////////////////////////////////////////////////
+#define DISCOVERY_PORT                 (5415)
+#define DISCOVERY_MAGIC                (0x444c4847)   // 'GHLD'
+#define DISCOVERY_VERSION              (2)
+
+#define DISCOVERY_MAX_NAME             (64)
+#define DISCOVERY_MAX_HOSTS            (256)
+#define DISCOVERY_MAX_PENDING          (64)
+
+#define DISCOVERY_DEFAULT_TTL          (5.0)    // seconds a host stays cached without a fresh response
+#define DISCOVERY_DEFAULT_MAX_DELAY    (0.1)    // seconds a responder may wait before replying
+
+// TYPES ////////////////////////////////////////////////////////////////////
+enum eDiscoveryPacketType : uint8_t
+{
+   DISCOVERY_QUERY = 1,
+   DISCOVERY_RESPONSE = 2,
+};
+
+// Wire format (little endian, no padding)
+//    header:   magic(4) version(1) type(1) game_port(2) nonce(4) time_us(4)
+//    response: held_us(4) name_len(1) name[name_len]
+// Times are in microseconds and wrap; only differences are meaningful.
+// held_us is how long the responder sat on the query before answering, so the
+// asker can take it back out of the round trip when measuring ping.
+struct DiscoveryPacket
+{
+   uint8_t type;
+   uint16_t game_port;
+   uint32_t nonce;
+   uint32_t time_us;
+   uint32_t held_us;
+   char name[DISCOVERY_MAX_NAME];
+};
+
+struct DiscoveredHost
+{
+   sockaddr_storage addr;
+   int addr_len;
+   uint16_t game_port;
+   char name[DISCOVERY_MAX_NAME];
+   float ping_ms;
+   double last_seen;
+};
+
+// Answers discovery queries.  Replies are held back for a random delay so a
+// broadcast query doesn't get every host on the subnet answering at once.
+class DiscoveryResponder
+{
+   public:
+      DiscoveryResponder();
+      ~DiscoveryResponder();
+
+      bool start( char const *ip, uint16_t port, uint16_t game_port, char const *name );
+      void stop();
+      void update();
+
+      uint16_t get_port() const;
+      SOCKET get_socket() const;
+
+   public:
+      double max_delay;
+
+   private:
+      struct PendingResponse
+      {
+         sockaddr_storage to;
+         int to_len;
+         uint32_t nonce;
+         uint32_t time_us;
+         double received_at;
+         double send_at;
+      };
+
+      SOCKET sock;
+      uint16_t game_port;
+      char name[DISCOVERY_MAX_NAME];
+
+      PendingResponse pending[DISCOVERY_MAX_PENDING];
+      uint32_t pending_count;
+};
+
+// Sends discovery queries and keeps a cache of everyone who answered.  Reading
+// the cache never touches the network.
+class DiscoveryClient
+{
+   public:
+      DiscoveryClient();
+      ~DiscoveryClient();
+
+      bool start();
+      void stop();
+      void update();
+
+      bool broadcast_query( uint16_t port );
+      bool send_query( sockaddr const *addr, int addr_len );
+
+      DiscoveredHost const* get_hosts( uint32_t *out_count ) const;
+      DiscoveredHost const* find_host( char const *name ) const;
+      void clear();
+
+   public:
+      double ttl;
+
+   private:
+      void cache_response( DiscoveryPacket const &packet, sockaddr const *from, int from_len, double now );
+
+   private:
+      SOCKET sock;
+      uint32_t nonce;
+
+      DiscoveredHost hosts[DISCOVERY_MAX_HOSTS];
+      uint32_t host_count;
+};
+
+// FUNCTION PROTOTYPES //////////////////////////////////////////////////////
+size_t DiscoveryWritePacket( uint8_t *buffer, size_t buffer_size, DiscoveryPacket const &packet );
+bool DiscoveryReadPacket( DiscoveryPacket *out, uint8_t const *buffer, size_t size );
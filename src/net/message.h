@@ -0,0 +1,210 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <utility>
+
+// Messages are registered at compile time.  Each message is a struct that declares
+// its id and how to serialize itself:
+//
+//    struct ChatMessage
+//    {
+//       static constexpr uint8_t ID = 3;
+//       bool write( MessageWriter &writer ) const;
+//       bool read( MessageReader &reader );
+//    };
+//
+// A MessageDispatcher<Handler, ChatMessage, ...> then routes a received buffer
+// straight to Handler::on_message( ChatMessage const& ) through a table built
+// at compile time - no virtuals, maps or string compares on the receive path.
+//
+// Wire format is [id (1B)][message body].
+
+// DEFINES //////////////////////////////////////////////////////////////////
+#define MESSAGE_MAX_TYPES              (256)
+#define MESSAGE_ID_SIZE                (1)
+
+// TYPES ////////////////////////////////////////////////////////////////////
+class MessageWriter
+{
+   public:
+      MessageWriter( void *out_buffer, size_t buffer_size ) 
+         : buffer((uint8_t*)out_buffer), capacity(buffer_size), offset(0) {}
+
+      bool write_bytes( void const *data, size_t size )
+      {
+         if ((offset + size) > capacity) {
+            return false;
+         }
+
+         memcpy( buffer + offset, data, size );
+         offset += size;
+         return true;
+      }
+
+      template <typename T>
+      bool write( T const &value ) { return write_bytes( &value, sizeof(T) ); }
+
+      size_t get_size() const { return offset; }
+
+   private:
+      uint8_t *buffer;
+      size_t capacity;
+      size_t offset;
+};
+
+class MessageReader
+{
+   public:
+      MessageReader( void const *in_buffer, size_t buffer_size ) 
+         : buffer((uint8_t const*)in_buffer), size(buffer_size), offset(0) {}
+
+      bool read_bytes( void *out, size_t count )
+      {
+         if ((offset + count) > size) {
+            return false;
+         }
+
+         memcpy( out, buffer + offset, count );
+         offset += count;
+         return true;
+      }
+
+      // Points into the received buffer instead of copying - only valid while it is.
+      bool read_view( void const **out, size_t count )
+      {
+         if ((offset + count) > size) {
+            return false;
+         }
+
+         *out = buffer + offset;
+         offset += count;
+         return true;
+      }
+
+      template <typename T>
+      bool read( T *out ) { return read_bytes( out, sizeof(T) ); }
+
+      size_t get_remaining() const { return size - offset; }
+
+   private:
+      uint8_t const *buffer;
+      size_t size;
+      size_t offset;
+};
+
+// INTERNAL TEMPLATES ///////////////////////////////////////////////////////
+template <typename HANDLER>
+bool DispatchUnknownMessage( HANDLER&, MessageReader& )
+{
+   return false;
+}
+
+//-------------------------------------------------------------------------------------------------------
+template <typename HANDLER, typename MSG>
+bool DispatchTypedMessage( HANDLER &handler, MessageReader &reader )
+{
+   // leftover bytes mean it wasn't really this message
+   MSG msg;
+   if (!msg.read(reader) || (reader.get_remaining() != 0)) {
+      return false;
+   }
+
+   handler.on_message(msg);
+   return true;
+}
+
+//-------------------------------------------------------------------------------------------------------
+// Every registered message becomes one base of MessageRegistry, tagged with its id.
+// Looking up an id is then a single overload resolution against those bases -
+// MSG is deduced from whichever base has that id - so building the whole table
+// is linear in the number of messages instead of a search per id.
+template <size_t ID, typename MSG>
+struct MessageEntry {};
+
+template <typename... MESSAGES>
+struct MessageRegistry : MessageEntry<MESSAGES::ID, MESSAGES>... {};
+
+template <typename HANDLER>
+using message_dispatch_fn = bool (*)( HANDLER&, MessageReader& );
+
+template <typename HANDLER, size_t ID, typename MSG>
+constexpr message_dispatch_fn<HANDLER> FindMessageDispatch( MessageEntry<ID, MSG> const* )
+{
+   return &DispatchTypedMessage<HANDLER, MSG>;
+}
+
+// Nothing registered under ID (or more than one message is, which makes the above ambiguous).
+template <typename HANDLER, size_t ID>
+constexpr message_dispatch_fn<HANDLER> FindMessageDispatch( ... )
+{
+   return &DispatchUnknownMessage<HANDLER>;
+}
+
+//-------------------------------------------------------------------------------------------------------
+constexpr bool AllOf()
+{
+   return true;
+}
+
+template <typename... REST>
+constexpr bool AllOf( bool first, REST... rest )
+{
+   return first && AllOf( rest... );
+}
+
+// DISPATCHER ///////////////////////////////////////////////////////////////
+template <typename HANDLER, typename... MESSAGES>
+class MessageDispatcher
+{
+   public:
+      typedef message_dispatch_fn<HANDLER> dispatch_fn;
+      typedef MessageRegistry<MESSAGES...> registry;
+
+      // each message must be the one found for its own id
+      static_assert( AllOf( (FindMessageDispatch<HANDLER, MESSAGES::ID>( (registry const*)nullptr ) 
+            == &DispatchTypedMessage<HANDLER, MESSAGES>)... ), 
+         "Two messages registered with the same ID." );
+
+      // Returns false if the id isn't registered, or the body fails to read or has bytes left over.
+      static bool dispatch( HANDLER &handler, void const *data, size_t size )
+      {
+         if (size < MESSAGE_ID_SIZE) {
+            return false;
+         }
+
+         uint8_t id = *(uint8_t const*)data;
+         MessageReader reader( (uint8_t const*)data + MESSAGE_ID_SIZE, size - MESSAGE_ID_SIZE );
+         return get_table()[id]( handler, reader );
+      }
+
+      // Returns number of bytes written, or 0 if the message didn't fit.
+      template <typename MSG>
+      static size_t write( MSG const &msg, void *buffer, size_t buffer_size )
+      {
+         static_assert( FindMessageDispatch<HANDLER, MSG::ID>( (registry const*)nullptr ) == &DispatchTypedMessage<HANDLER, MSG>, 
+            "Message is not registered with this dispatcher." );
+
+         MessageWriter writer( buffer, buffer_size );
+         uint8_t id = MSG::ID;
+         if (!writer.write(id) || !msg.write(writer)) {
+            return 0;
+         }
+
+         return writer.get_size();
+      }
+
+   private:
+      static dispatch_fn const* get_table()
+      {
+         return build_table( std::make_index_sequence<MESSAGE_MAX_TYPES>() );
+      }
+
+      template <size_t... IDS>
+      static dispatch_fn const* build_table( std::index_sequence<IDS...> )
+      {
+         static constexpr dispatch_fn table[] = { FindMessageDispatch<HANDLER, IDS>( (registry const*)nullptr )... };
+         return table;
+      }
+};
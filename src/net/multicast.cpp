@@ -0,0 +1,134 @@
+#include "net/multicast.h"
+
+#include <string.h>
+
+// INTERNAL FUNCTIONS //////////////////////////////////////////////////////////////
+//-------------------------------------------------------------------------------------------------------
+static bool SetOption( SOCKET sock, int level, int option, void const *value, int value_size )
+{
+   return (setsockopt( sock, level, option, (char const*)value, value_size ) != SOCKET_ERROR);
+}
+
+//-------------------------------------------------------------------------------------------------------
+static bool ChangeMembership( SOCKET sock, sockaddr const *group, sockaddr const *local_interface, bool join )
+{
+   if (group->sa_family == AF_INET) {
+      ip_mreq request;
+      memset( &request, 0, sizeof(request) );
+      request.imr_multiaddr = ((sockaddr_in const*)group)->sin_addr;
+      if (nullptr != local_interface) {
+         request.imr_interface = ((sockaddr_in const*)local_interface)->sin_addr;
+      } else {
+         request.imr_interface.s_addr = htonl(INADDR_ANY);
+      }
+
+      int option = join ? IP_ADD_MEMBERSHIP : IP_DROP_MEMBERSHIP;
+      return SetOption( sock, IPPROTO_IP, option, &request, sizeof(request) );
+   } else if (group->sa_family == AF_INET6) {
+      ipv6_mreq request;
+      memset( &request, 0, sizeof(request) );
+      request.ipv6mr_multiaddr = ((sockaddr_in6 const*)group)->sin6_addr;
+      if (nullptr != local_interface) {
+         request.ipv6mr_interface = ((sockaddr_in6 const*)local_interface)->sin6_scope_id;
+      }
+
+      int option = join ? IPV6_ADD_MEMBERSHIP : IPV6_DROP_MEMBERSHIP;
+      return SetOption( sock, IPPROTO_IPV6, option, &request, sizeof(request) );
+   }
+
+   return false;
+}
+
+// EXTERNAL FUNCTIONS //////////////////////////////////////////////////////////////
+//-------------------------------------------------------------------------------------------------------
+SOCKET MulticastCreateSocket( int family, uint16_t port, bool reuse )
+{
+   SOCKET sock = socket( family, SOCK_DGRAM, IPPROTO_UDP );
+   if (sock == INVALID_SOCKET) {
+      return INVALID_SOCKET;
+   }
+
+   if (reuse) {
+      int enable = 1;
+      SetOption( sock, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable) );
+   }
+
+   sockaddr_storage addr;
+   int addr_len;
+   memset( &addr, 0, sizeof(addr) );
+   if (family == AF_INET) {
+      sockaddr_in *addr4 = (sockaddr_in*)&addr;
+      addr4->sin_family = AF_INET;
+      addr4->sin_port = htons(port);
+      addr4->sin_addr.s_addr = htonl(INADDR_ANY);
+      addr_len = sizeof(sockaddr_in);
+   } else {
+      sockaddr_in6 *addr6 = (sockaddr_in6*)&addr;
+      addr6->sin6_family = AF_INET6;
+      addr6->sin6_port = htons(port);
+      addr6->sin6_addr = in6addr_any;
+      addr_len = sizeof(sockaddr_in6);
+   }
+
+   if (bind( sock, (sockaddr*)&addr, addr_len ) == SOCKET_ERROR) {
+      closesocket(sock);
+      return INVALID_SOCKET;
+   }
+
+   return sock;
+}
+
+//-------------------------------------------------------------------------------------------------------
+bool MulticastJoin( SOCKET sock, sockaddr const *group, sockaddr const *local_interface )
+{
+   return ChangeMembership( sock, group, local_interface, true );
+}
+
+//-------------------------------------------------------------------------------------------------------
+bool MulticastLeave( SOCKET sock, sockaddr const *group, sockaddr const *local_interface )
+{
+   return ChangeMembership( sock, group, local_interface, false );
+}
+
+//-------------------------------------------------------------------------------------------------------
+bool MulticastSetInterface( SOCKET sock, sockaddr const *local_interface )
+{
+   if (local_interface->sa_family == AF_INET) {
+      in_addr addr = ((sockaddr_in const*)local_interface)->sin_addr;
+      return SetOption( sock, IPPROTO_IP, IP_MULTICAST_IF, &addr, sizeof(addr) );
+   } else {
+      DWORD index = ((sockaddr_in6 const*)local_interface)->sin6_scope_id;
+      return SetOption( sock, IPPROTO_IPV6, IPV6_MULTICAST_IF, &index, sizeof(index) );
+   }
+}
+
+//-------------------------------------------------------------------------------------------------------
+bool MulticastSetTTL( SOCKET sock, int family, int ttl )
+{
+   // number of router hops the packet is allowed - 1 keeps it on the local subnet
+   if (family == AF_INET) {
+      DWORD value = (DWORD)ttl;
+      return SetOption( sock, IPPROTO_IP, IP_MULTICAST_TTL, &value, sizeof(value) );
+   } else {
+      DWORD value = (DWORD)ttl;
+      return SetOption( sock, IPPROTO_IPV6, IPV6_MULTICAST_HOPS, &value, sizeof(value) );
+   }
+}
+
+//-------------------------------------------------------------------------------------------------------
+bool MulticastSetLoopback( SOCKET sock, int family, bool enabled )
+{
+   // on a subscriber: whether it receives group sends that originate on this machine
+   DWORD value = enabled ? 1 : 0;
+   if (family == AF_INET) {
+      return SetOption( sock, IPPROTO_IP, IP_MULTICAST_LOOP, &value, sizeof(value) );
+   } else {
+      return SetOption( sock, IPPROTO_IPV6, IPV6_MULTICAST_LOOP, &value, sizeof(value) );
+   }
+}
+
+//-------------------------------------------------------------------------------------------------------
+int MulticastSend( SOCKET sock, sockaddr const *group, int group_len, void const *data, size_t size )
+{
+   return sendto( sock, (char const*)data, (int)size, 0, group, group_len );
+}
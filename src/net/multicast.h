@@ -0,0 +1,23 @@
+#pragma once
+
+#include "net/net.h"
+
+// FUNCTION PROTOTYPES //////////////////////////////////////////////////////
+// Creates a UDP socket bound to the wildcard address on port.  Multiple
+// subscribers on one machine can share the port when reuse is set.
+SOCKET MulticastCreateSocket( int family, uint16_t port, bool reuse );
+
+// local_interface selects which interface to use - the interface address for
+// IPv4, or the scope id for IPv6.  Pass nullptr to let the OS pick.
+bool MulticastJoin( SOCKET sock, sockaddr const *group, sockaddr const *local_interface = nullptr );
+bool MulticastLeave( SOCKET sock, sockaddr const *group, sockaddr const *local_interface = nullptr );
+
+bool MulticastSetInterface( SOCKET sock, sockaddr const *local_interface );
+bool MulticastSetTTL( SOCKET sock, int family, int ttl );
+
+// Winsock applies loopback to the *receiving* socket - it decides whether that
+// subscriber sees group traffic sent from this machine.  (Unix applies it to the
+// sender instead.)  Set it on subscribers; on a publisher it does nothing.
+bool MulticastSetLoopback( SOCKET sock, int family, bool enabled );
+
+int MulticastSend( SOCKET sock, sockaddr const *group, int group_len, void const *data, size_t size );
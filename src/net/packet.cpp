@@ -0,0 +1,240 @@
+#include "net/packet.h"
+
+#include <string.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+   #define CRC32C_HAS_SSE42
+   #include <nmmintrin.h>
+   #if defined(_MSC_VER)
+      #include <intrin.h>
+      #define CRC32C_TARGET_SSE42
+   #else
+      #include <cpuid.h>
+      #define CRC32C_TARGET_SSE42 __attribute__((target("sse4.2")))
+   #endif
+#endif
+
+#define CRC32C_POLYNOMIAL     (0x82f63b78)   // reversed Castagnoli polynomial
+
+// TYPES ////////////////////////////////////////////////////////////////////
+typedef uint32_t(*crc_fn)( uint8_t const *data, size_t size, uint32_t crc );
+
+// GLOBALS //////////////////////////////////////////////////////////////////
+static PacketStats gPacketStats = { 0, 0, 0, 0 };
+
+static uint32_t gCrcTable[8][256];
+static bool gCrcTableReady = false;
+
+// INTERNAL FUNCTIONS //////////////////////////////////////////////////////////////
+//-------------------------------------------------------------------------------------------------------
+static void BuildCrcTable()
+{
+   for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t crc = i;
+      for (uint32_t bit = 0; bit < 8; ++bit) {
+         crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLYNOMIAL : 0);
+      }
+      gCrcTable[0][i] = crc;
+   }
+
+   for (uint32_t i = 0; i < 256; ++i) {
+      for (uint32_t slice = 1; slice < 8; ++slice) {
+         uint32_t prev = gCrcTable[slice - 1][i];
+         gCrcTable[slice][i] = (prev >> 8) ^ gCrcTable[0][prev & 0xff];
+      }
+   }
+
+   gCrcTableReady = true;
+}
+
+//-------------------------------------------------------------------------------------------------------
+// Slicing-by-8: eight table lookups per 8 bytes instead of one per byte.
+static uint32_t CrcTable( uint8_t const *data, size_t size, uint32_t crc )
+{
+   if (!gCrcTableReady) {
+      BuildCrcTable();
+   }
+
+   while (size >= 8) {
+      uint32_t lo;
+      uint32_t hi;
+      memcpy( &lo, data, sizeof(lo) );
+      memcpy( &hi, data + 4, sizeof(hi) );
+      lo ^= crc;
+
+      crc = gCrcTable[7][lo & 0xff]
+         ^ gCrcTable[6][(lo >> 8) & 0xff]
+         ^ gCrcTable[5][(lo >> 16) & 0xff]
+         ^ gCrcTable[4][lo >> 24]
+         ^ gCrcTable[3][hi & 0xff]
+         ^ gCrcTable[2][(hi >> 8) & 0xff]
+         ^ gCrcTable[1][(hi >> 16) & 0xff]
+         ^ gCrcTable[0][hi >> 24];
+
+      data += 8;
+      size -= 8;
+   }
+
+   while (size > 0) {
+      crc = (crc >> 8) ^ gCrcTable[0][(crc ^ *data) & 0xff];
+      ++data;
+      --size;
+   }
+
+   return crc;
+}
+
+#if defined(CRC32C_HAS_SSE42)
+//-------------------------------------------------------------------------------------------------------
+CRC32C_TARGET_SSE42 static uint32_t CrcSSE42( uint8_t const *data, size_t size, uint32_t crc )
+{
+#if defined(_M_X64) || defined(__x86_64__)
+   uint64_t crc64 = crc;
+   while (size >= 8) {
+      uint64_t v;
+      memcpy( &v, data, sizeof(v) );
+      crc64 = _mm_crc32_u64( crc64, v );
+      data += 8;
+      size -= 8;
+   }
+   crc = (uint32_t)crc64;
+#endif
+
+   while (size >= 4) {
+      uint32_t v;
+      memcpy( &v, data, sizeof(v) );
+      crc = _mm_crc32_u32( crc, v );
+      data += 4;
+      size -= 4;
+   }
+
+   while (size > 0) {
+      crc = _mm_crc32_u8( crc, *data );
+      ++data;
+      --size;
+   }
+
+   return crc;
+}
+
+//-------------------------------------------------------------------------------------------------------
+static bool CpuHasSSE42()
+{
+#if defined(_MSC_VER)
+   int info[4];
+   __cpuid( info, 1 );
+   return (info[2] & (1 << 20)) != 0;
+#else
+   unsigned int eax, ebx, ecx, edx;
+   if (!__get_cpuid( 1, &eax, &ebx, &ecx, &edx )) {
+      return false;
+   }
+   return (ecx & bit_SSE4_2) != 0;
+#endif
+}
+#endif
+
+//-------------------------------------------------------------------------------------------------------
+static crc_fn PickCrcImplementation()
+{
+#if defined(CRC32C_HAS_SSE42)
+   if (CpuHasSSE42()) {
+      return CrcSSE42;
+   }
+#endif
+
+   return CrcTable;
+}
+
+//-------------------------------------------------------------------------------------------------------
+static uint32_t CrcDetect( uint8_t const *data, size_t size, uint32_t crc );
+static crc_fn gCrcImpl = CrcDetect;
+
+// First call picks the implementation; every call after goes straight to it.
+static uint32_t CrcDetect( uint8_t const *data, size_t size, uint32_t crc )
+{
+   gCrcImpl = PickCrcImplementation();
+   return gCrcImpl( data, size, crc );
+}
+
+//-------------------------------------------------------------------------------------------------------
+static uint32_t ComputePacketCrc( uint8_t const *packet, size_t payload_size )
+{
+   uint32_t crc = Crc32c( packet, sizeof(uint16_t) );
+   return Crc32c( packet + PACKET_HEADER_SIZE, payload_size, crc );
+}
+
+// EXTERNAL FUNCTIONS //////////////////////////////////////////////////////////////
+//-------------------------------------------------------------------------------------------------------
+size_t PacketWriteHeader( void *packet, size_t payload_size )
+{
+   uint8_t *header = (uint8_t*)packet;
+   uint16_t protocol_id = PACKET_PROTOCOL_ID;
+   memcpy( header, &protocol_id, sizeof(protocol_id) );
+
+   uint32_t crc = ComputePacketCrc( header, payload_size );
+   memcpy( header + sizeof(protocol_id), &crc, sizeof(crc) );
+
+   return PACKET_HEADER_SIZE + payload_size;
+}
+
+//-------------------------------------------------------------------------------------------------------
+void const* PacketOpen( size_t *out_payload_size, void const *packet, size_t packet_size )
+{
+   uint8_t const *header = (uint8_t const*)packet;
+
+   // cheapest checks first - stray traffic shouldn't cost a checksum
+   if (packet_size < PACKET_HEADER_SIZE) {
+      ++gPacketStats.dropped_too_small;
+      return nullptr;
+   }
+
+   uint16_t protocol_id;
+   memcpy( &protocol_id, header, sizeof(protocol_id) );
+   if (protocol_id != PACKET_PROTOCOL_ID) {
+      ++gPacketStats.dropped_bad_protocol;
+      return nullptr;
+   }
+
+   uint32_t crc;
+   memcpy( &crc, header + sizeof(protocol_id), sizeof(crc) );
+   size_t payload_size = packet_size - PACKET_HEADER_SIZE;
+   if (crc != ComputePacketCrc( header, payload_size )) {
+      ++gPacketStats.dropped_bad_checksum;
+      return nullptr;
+   }
+
+   ++gPacketStats.accepted;
+   *out_payload_size = payload_size;
+   return header + PACKET_HEADER_SIZE;
+}
+
+//-------------------------------------------------------------------------------------------------------
+PacketStats const* PacketGetStats()
+{
+   return &gPacketStats;
+}
+
+//-------------------------------------------------------------------------------------------------------
+void PacketResetStats()
+{
+   memset( &gPacketStats, 0, sizeof(gPacketStats) );
+}
+
+//-------------------------------------------------------------------------------------------------------
+uint32_t Crc32c( void const *data, size_t size, uint32_t crc )
+{
+   return ~gCrcImpl( (uint8_t const*)data, size, ~crc );
+}
+
+//-------------------------------------------------------------------------------------------------------
+uint32_t Crc32cPortable( void const *data, size_t size, uint32_t crc )
+{
+   return ~CrcTable( (uint8_t const*)data, size, ~crc );
+}
+
+//-------------------------------------------------------------------------------------------------------
+bool Crc32cIsAccelerated()
+{
+   return PickCrcImplementation() != CrcTable;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// DEFINES //////////////////////////////////////////////////////////////////
+// Every datagram on the game port starts with this header
+//    [protocol id (2B)][crc32c (4B)][payload]
+// The checksum covers the protocol id and the payload.  Anything that doesn't
+// match is dropped before we spend any other time on it.
+#define PACKET_PROTOCOL_ID             (0x4847)    // 'GH'
+#define PACKET_HEADER_SIZE             (6)
+
+// TYPES ////////////////////////////////////////////////////////////////////
+struct PacketStats
+{
+   uint64_t accepted;
+   uint64_t dropped_too_small;
+   uint64_t dropped_bad_protocol;
+   uint64_t dropped_bad_checksum;
+};
+
+// FUNCTION PROTOTYPES //////////////////////////////////////////////////////
+// The payload must already be written at packet + PACKET_HEADER_SIZE.
+// Returns the total packet size.
+size_t PacketWriteHeader( void *packet, size_t payload_size );
+
+// Returns the payload, or nullptr (and counts the drop) if the packet isn't ours or is corrupt.
+void const* PacketOpen( size_t *out_payload_size, void const *packet, size_t packet_size );
+
+PacketStats const* PacketGetStats();
+void PacketResetStats();
+
+// CRC32C (Castagnoli).  Uses the SSE4.2 crc32 instruction when the CPU has it,
+// otherwise a slicing-by-8 table.  Pass a previous result as crc to continue it.
+uint32_t Crc32c( void const *data, size_t size, uint32_t crc = 0 );
+uint32_t Crc32cPortable( void const *data, size_t size, uint32_t crc = 0 );
+bool Crc32cIsAccelerated();
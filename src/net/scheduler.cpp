@@ -0,0 +1,216 @@
+#include "net/scheduler.h"
+
+#include <malloc.h>
+#include <string.h>
+
+// INTERNAL FUNCTIONS //////////////////////////////////////////////////////////////
+//-------------------------------------------------------------------------------------------------------
+static uint16_t ChannelPeekSize( MessageChannel const *channel )
+{
+   uint16_t size;
+   memcpy( &size, channel->data + channel->read, sizeof(size) );
+   return size;
+}
+
+//-------------------------------------------------------------------------------------------------------
+static bool ChannelReserve( MessageChannel *channel, size_t size )
+{
+   if ((channel->write + size) <= channel->capacity) {
+      return true;
+   }
+
+   // slide the unread bytes to the front before growing
+   if (channel->read > 0) {
+      size_t used = channel->write - channel->read;
+      memmove( channel->data, channel->data + channel->read, used );
+      channel->read = 0;
+      channel->write = used;
+
+      if ((channel->write + size) <= channel->capacity) {
+         return true;
+      }
+   }
+
+   size_t new_capacity = (channel->capacity == 0) ? 1024 : channel->capacity * 2;
+   while (new_capacity < (channel->write + size)) {
+      new_capacity *= 2;
+   }
+
+   uint8_t *new_data = (uint8_t*)realloc( channel->data, new_capacity );
+   if (nullptr == new_data) {
+      return false;
+   }
+
+   channel->data = new_data;
+   channel->capacity = new_capacity;
+   return true;
+}
+
+// EXTERNAL FUNCTIONS //////////////////////////////////////////////////////////////
+//-------------------------------------------------------------------------------------------------------
+MessageScheduler::MessageScheduler()
+{
+   memset( channels, 0, sizeof(channels) );
+   for (uint32_t i = 0; i < SCHEDULER_MAX_TYPES; ++i) {
+      channels[i].priority = 1.0f;
+   }
+
+   active_count = 0;
+   tick_index = 0;
+   queued_count = 0;
+   queued_bytes = 0;
+}
+
+//-------------------------------------------------------------------------------------------------------
+MessageScheduler::~MessageScheduler()
+{
+   for (uint32_t i = 0; i < SCHEDULER_MAX_TYPES; ++i) {
+      free( channels[i].data );
+   }
+}
+
+//-------------------------------------------------------------------------------------------------------
+void MessageScheduler::set_priority( uint8_t type, float priority )
+{
+   channels[type].priority = priority;
+}
+
+//-------------------------------------------------------------------------------------------------------
+float MessageScheduler::get_priority( uint8_t type ) const
+{
+   return channels[type].priority;
+}
+
+//-------------------------------------------------------------------------------------------------------
+bool MessageScheduler::enqueue( uint8_t type, void const *payload, uint16_t size )
+{
+   if (size > SCHEDULER_MAX_PAYLOAD_SIZE) {
+      return false;
+   }
+
+   MessageChannel *channel = &channels[type];
+   if (!ChannelReserve( channel, sizeof(size) + size )) {
+      return false;
+   }
+
+   memcpy( channel->data + channel->write, &size, sizeof(size) );
+   memcpy( channel->data + channel->write + sizeof(size), payload, size );
+   channel->write += sizeof(size) + size;
+
+   if (channel->count == 0) {
+      activate(type);
+   }
+   ++channel->count;
+
+   ++queued_count;
+   queued_bytes += size;
+   return true;
+}
+
+//-------------------------------------------------------------------------------------------------------
+size_t MessageScheduler::tick( size_t byte_budget, packet_send_cb cb, void *user_arg )
+{
+   ++tick_index;
+
+   // everything still waiting gets a little more important
+   for (uint32_t i = 0; i < active_count; ++i) {
+      MessageChannel *channel = &channels[active[i]];
+      channel->accumulated += channel->priority;
+   }
+
+   uint8_t packet[SCHEDULER_PACKET_SIZE];
+   size_t packet_size = 0;
+   size_t sent = 0;
+
+   for (;;) {
+      MessageChannel *channel = find_best_channel( byte_budget - sent - packet_size );
+      if (nullptr == channel) {
+         break;
+      }
+
+      uint8_t type = (uint8_t)(channel - channels);
+      channel->visited_tick = tick_index;
+      channel->accumulated = 0.0f;
+
+      // drain as much of this type as the budget allows
+      while (channel->count > 0) {
+         uint16_t size = ChannelPeekSize(channel);
+         size_t needed = SCHEDULER_MESSAGE_HEADER_SIZE + size;
+         if ((sent + packet_size + needed) > byte_budget) {
+            break;
+         }
+
+         if ((packet_size + needed) > SCHEDULER_PACKET_SIZE) {
+            cb( packet, packet_size, user_arg );
+            sent += packet_size;
+            packet_size = 0;
+         }
+
+         packet[packet_size] = type;
+         memcpy( packet + packet_size + 1, &size, sizeof(size) );
+         memcpy( packet + packet_size + SCHEDULER_MESSAGE_HEADER_SIZE, 
+            channel->data + channel->read + sizeof(size), 
+            size );
+         packet_size += needed;
+
+         channel->read += sizeof(size) + size;
+         --channel->count;
+         --queued_count;
+         queued_bytes -= size;
+      }
+
+      if (channel->count == 0) {
+         channel->read = 0;
+         channel->write = 0;
+         deactivate(type);
+      }
+   }
+
+   if (packet_size > 0) {
+      cb( packet, packet_size, user_arg );
+      sent += packet_size;
+   }
+
+   return sent;
+}
+
+//-------------------------------------------------------------------------------------------------------
+MessageChannel* MessageScheduler::find_best_channel( size_t remaining )
+{
+   MessageChannel *best = nullptr;
+   for (uint32_t i = 0; i < active_count; ++i) {
+      MessageChannel *channel = &channels[active[i]];
+      if (channel->visited_tick == tick_index) {
+         continue;
+      }
+
+      if ((size_t)(SCHEDULER_MESSAGE_HEADER_SIZE + ChannelPeekSize(channel)) > remaining) {
+         continue;
+      }
+
+      if ((nullptr == best) || (channel->accumulated > best->accumulated)) {
+         best = channel;
+      }
+   }
+
+   return best;
+}
+
+//-------------------------------------------------------------------------------------------------------
+void MessageScheduler::activate( uint8_t type )
+{
+   channels[type].active_index = active_count;
+   active[active_count] = type;
+   ++active_count;
+}
+
+//-------------------------------------------------------------------------------------------------------
+void MessageScheduler::deactivate( uint8_t type )
+{
+   uint32_t index = channels[type].active_index;
+   --active_count;
+
+   uint8_t last = active[active_count];
+   active[index] = last;
+   channels[last].active_index = index;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// DEFINES //////////////////////////////////////////////////////////////////
+#define SCHEDULER_MAX_TYPES            (256)
+#define SCHEDULER_PACKET_SIZE          (1200)   // stay under a typical MTU once IP/UDP headers are added
+#define SCHEDULER_MESSAGE_HEADER_SIZE  (3)      // type (1B) + payload size (2B)
+#define SCHEDULER_MAX_PAYLOAD_SIZE     (SCHEDULER_PACKET_SIZE - SCHEDULER_MESSAGE_HEADER_SIZE)
+
+// TYPES ////////////////////////////////////////////////////////////////////
+// Called once for every packet filled during a tick.
+typedef void(*packet_send_cb)(void const *packet, size_t size, void *user_arg);
+
+struct MessageChannel
+{
+   float priority;
+   float accumulated;
+
+   // queued messages, stored back to back as [size (2B)][payload]
+   uint8_t *data;
+   size_t read;
+   size_t write;
+   size_t capacity;
+   uint32_t count;
+
+   uint32_t active_index;
+   uint32_t visited_tick;
+};
+
+// One scheduler per peer.  Messages are queued by type, and each tick the
+// scheduler packs them into packets up to a byte budget.  Every tick a waiting
+// type gains its priority, and a type that gets to send is reset to zero - so
+// low priority traffic that keeps getting passed over eventually rises to the top.
+class MessageScheduler
+{
+   public:
+      MessageScheduler();
+      ~MessageScheduler();
+
+      void set_priority( uint8_t type, float priority );
+      float get_priority( uint8_t type ) const;
+
+      bool enqueue( uint8_t type, void const *payload, uint16_t size );
+
+      // Returns number of bytes sent this tick.
+      size_t tick( size_t byte_budget, packet_send_cb cb, void *user_arg );
+
+      uint32_t get_queued_count() const { return queued_count; }
+      size_t get_queued_bytes() const { return queued_bytes; }
+
+   private:
+      MessageScheduler( MessageScheduler const& );
+      MessageScheduler& operator=( MessageScheduler const& );
+
+      MessageChannel* find_best_channel( size_t remaining );
+      void activate( uint8_t type );
+      void deactivate( uint8_t type );
+
+   private:
+      MessageChannel channels[SCHEDULER_MAX_TYPES];
+
+      // types that currently have messages queued
+      uint8_t active[SCHEDULER_MAX_TYPES];
+      uint32_t active_count;
+
+      uint32_t tick_index;
+      uint32_t queued_count;
+      size_t queued_bytes;
+};